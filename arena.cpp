@@ -0,0 +1,95 @@
+/**
+ * @file arena.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of arena (bump) allocator used for parsed dns packets
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "arena.h"
+
+#include <new>
+
+Arena::Arena(const size_t chunk_size) : chunk_size(chunk_size) {}
+
+/**
+ * @brief Releases all chunks back to the system
+ */
+Arena::~Arena() {
+    while (head != nullptr) {
+        Chunk* next = head->next;
+        ::operator delete(head);
+        head = next;
+    }
+}
+
+/**
+ * @brief Rewinds the arena to the first chunk, all previously allocated memory becomes invalid
+ */
+void Arena::reset() {
+    current = head;
+    ptr = head != nullptr ? reinterpret_cast<uint8_t*>(head + 1) : nullptr;
+    end = head != nullptr ? ptr + head->size : nullptr;
+    used = 0;
+}
+
+/**
+ * @brief Makes chunk current, if requested block fits into it
+ * @param chunk chunk to use
+ * @param bytes requested size
+ * @param alignment requested alignment
+ * @return true if block fits into chunk
+ */
+bool Arena::useChunk(Chunk* chunk, const size_t bytes, const size_t alignment) {
+    uint8_t* data = reinterpret_cast<uint8_t*>(chunk + 1);
+    const size_t padding = (alignment - reinterpret_cast<uintptr_t>(data) % alignment) % alignment;
+    if (padding + bytes > chunk->size) {
+        return false;
+    }
+    current = chunk;
+    ptr = data;
+    end = data + chunk->size;
+    return true;
+}
+
+/**
+ * @brief Allocates block from current chunk, moves to next (or new) chunk when current is full
+ * @param bytes requested size
+ * @param alignment requested alignment
+ * @return pointer to allocated block
+ */
+void* Arena::do_allocate(const size_t bytes, const size_t alignment) {
+    allocations++;
+
+    size_t padding = ptr != nullptr ? (alignment - reinterpret_cast<uintptr_t>(ptr) % alignment) % alignment : 0;
+    if (ptr == nullptr || padding + bytes > static_cast<size_t>(end - ptr)) {
+        // Try chunks kept from before the last reset
+        Chunk* chunk = current != nullptr ? current->next : nullptr;
+        while (chunk != nullptr && !useChunk(chunk, bytes, alignment)) {
+            chunk = chunk->next;
+        }
+
+        // Allocate new chunk and link it after the current one
+        if (chunk == nullptr) {
+            const size_t size = bytes + alignment > chunk_size ? bytes + alignment : chunk_size;
+            chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + size));
+            chunk->size = size;
+            if (current == nullptr) {
+                chunk->next = head;
+                head = chunk;
+            } else {
+                chunk->next = current->next;
+                current->next = chunk;
+            }
+            capacity += size;
+            useChunk(chunk, bytes, alignment);
+        }
+
+        padding = (alignment - reinterpret_cast<uintptr_t>(ptr) % alignment) % alignment;
+    }
+
+    void* block = ptr + padding;
+    ptr += padding + bytes;
+    used += padding + bytes;
+    return block;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file arena.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of arena (bump) allocator used for parsed dns packets
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+// size of one arena chunk, enough for a batch of ordinary responses including formatted output
+constexpr size_t ARENA_CHUNK_SIZE = 64 * 1024;
+// number of responses processed in bulk mode before the arena is reset
+constexpr size_t ARENA_BATCH_SIZE = 64;
+
+/**
+ * @brief Monotonic memory resource that hands out memory from large chunks.
+ * Deallocation is a no-op, all memory is reclaimed at once by reset() (chunks are kept for reuse)
+ * or released back to the system when the arena is destroyed.
+ */
+class Arena : public std::pmr::memory_resource {
+public:
+    explicit Arena(size_t chunk_size = ARENA_CHUNK_SIZE);
+    ~Arena() override;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void reset();
+
+    size_t getUsed() const {
+        return used;
+    }
+
+    size_t getCapacity() const {
+        return capacity;
+    }
+
+    size_t getAllocations() const {
+        return allocations;
+    }
+
+private:
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    bool useChunk(Chunk* chunk, size_t bytes, size_t alignment);
+
+    size_t chunk_size;
+    Chunk* head = nullptr;
+    Chunk* current = nullptr;
+    uint8_t* ptr = nullptr;
+    uint8_t* end = nullptr;
+
+    size_t used = 0;
+    size_t capacity = 0;
+    size_t allocations = 0;
+};
+
+#endif // ARENA_H
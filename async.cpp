@@ -0,0 +1,228 @@
+/**
+ * @file async.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of coroutine query API on top of non-blocking resolver, part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "async.h"
+
+#include "stats.h"
+
+using namespace std;
+
+/**
+ * @brief Suspends awaiting coroutine and queues its query
+ * @param awaiting coroutine resumed when query completes
+ */
+void QueryAwaitable::await_suspend(const coroutine_handle<> awaiting) {
+    waiting = awaiting;
+    scheduler.submit(this);
+}
+
+/**
+ * @brief Creates group of queries, their questions are copied
+ * @param scheduler scheduler of the queries
+ * @param questions questions of the group
+ */
+QueryGroupAwaitable::QueryGroupAwaitable(AsyncResolver& scheduler, const vector<DNSQuestion>& questions) : scheduler(scheduler) {
+    queries.reserve(questions.size());
+    for (const auto& question : questions) {
+        queries.emplace_back(scheduler, question);
+    }
+}
+
+/**
+ * @brief Suspends awaiting coroutine and queues all queries of group
+ * @param awaiting coroutine resumed when all queries complete
+ */
+void QueryGroupAwaitable::await_suspend(const coroutine_handle<> awaiting) {
+    waiting = awaiting;
+    remaining = queries.size();
+    for (auto& query : queries) {
+        query.waiting = awaiting;
+        query.group = this;
+        scheduler.submit(&query);
+    }
+}
+
+/**
+ * @brief Results of queries in order of questions
+ * @return results of queries
+ */
+vector<QueryResult> QueryGroupAwaitable::await_resume() {
+    vector<QueryResult> results;
+    results.reserve(queries.size());
+    for (auto& query : queries) {
+        results.push_back(move(query.result));
+    }
+    return results;
+}
+
+/**
+ * @brief Creates awaitable query, with RR_TYPE::PTR name is address that is converted to reverse lookup name
+ * @param name name or address to resolve
+ * @param type type of query
+ * @return awaitable query
+ */
+QueryAwaitable AsyncResolver::query(const string& name, const RR_TYPE type) {
+    return QueryAwaitable(*this, DNSQuestion(name, type));
+}
+
+/**
+ * @brief Creates awaitable query of any type and class
+ * @param name name to resolve
+ * @param type type of query
+ * @param class_ class of query
+ * @return awaitable query
+ */
+QueryAwaitable AsyncResolver::query(const string& name, const uint16_t type, const uint16_t class_) {
+    return QueryAwaitable(*this, DNSQuestion(name, type, class_));
+}
+
+/**
+ * @brief Creates awaitable group of queries sent together, e.g. A and AAAA of one name
+ * @param questions questions of the group
+ * @return awaitable group, its result are results of queries in order of questions
+ */
+QueryGroupAwaitable AsyncResolver::queryAll(const vector<DNSQuestion>& questions) {
+    return QueryGroupAwaitable(*this, questions);
+}
+
+/**
+ * @brief Starts task on next iteration of run, task is owned by scheduler until run returns
+ * @param task task to start
+ */
+void AsyncResolver::spawn(Task<void> task) {
+    ready.push_back(task.handle);
+    tasks.push_back(move(task));
+}
+
+/**
+ * @brief Queues query for sending, after failure of resolver query completes immediately with the failure
+ * @param query awaited query
+ */
+void AsyncResolver::submit(QueryAwaitable* query) {
+    if (failure != ResolverStatus::Ok) {
+        query->result.status = failure;
+        complete(query);
+        return;
+    }
+    backlog.push_back(query);
+}
+
+/**
+ * @brief Schedules resumption of coroutine awaiting completed query (or its group when it was the last one)
+ * @param query completed query
+ */
+void AsyncResolver::complete(QueryAwaitable* query) {
+    if (query->group == nullptr || --query->group->remaining == 0) {
+        ready.push_back(query->waiting);
+    }
+}
+
+/**
+ * @brief Completes all queued and sent queries with status of failed resolver
+ * @param status status of failed resolver operation
+ */
+void AsyncResolver::failAll(const ResolverStatus status) {
+    failure = status;
+    for (const auto& [index, query] : in_flight) {
+        query->result.status = status;
+        complete(query);
+    }
+    in_flight.clear();
+    for (QueryAwaitable* query : backlog) {
+        query->result.status = status;
+        complete(query);
+    }
+    backlog.clear();
+}
+
+/**
+ * @brief Resumes coroutines and waits for responses until no coroutine can continue,
+ * coroutines are resumed outside of response handling, so they can await next queries right away
+ * @return Ok or first error of resolver (queries awaited after error complete with it)
+ */
+ResolverStatus AsyncResolver::run() {
+    if (!window_open) {
+        const ResolverStatus status = resolver.openWindow(window);
+        window_open = status == ResolverStatus::Ok;
+        if (!window_open) {
+            failAll(status);
+        }
+    }
+
+    const ResponseHandler handle_response = [this](const size_t index, const DNSQuestion&, const DNSPacket* response) {
+        const auto it = in_flight.find(index);
+        if (it == in_flight.end()) {
+            return; // query already failed
+        }
+        QueryAwaitable* query = it->second;
+        in_flight.erase(it);
+        if (response != nullptr) {
+            // response in arena is reused by next batch, awaiting coroutine gets its own copy
+            query->result.status = ResolverStatus::Ok;
+            query->result.packet.emplace(response->getRaw(), response->getRawLength());
+        } else {
+            query->result.status = ResolverStatus::Timeout;
+        }
+        complete(query);
+    };
+
+    while (true) {
+        // Resume coroutines with completed queries (or just spawned)
+        while (!ready.empty()) {
+            const coroutine_handle<> handle = ready.front();
+            ready.pop_front();
+            handle.resume();
+        }
+
+        // Send queued queries while window has free slots
+        while (!backlog.empty() && !resolver.windowFull()) {
+            QueryAwaitable* query = backlog.front();
+            backlog.pop_front();
+            size_t index;
+            const ResolverStatus status = resolver.submit(query->question, recursion, index);
+            in_flight[index] = query;
+            if (status != ResolverStatus::Ok) {
+                failAll(status);
+            }
+        }
+
+        if (!ready.empty()) {
+            continue;
+        }
+        // No query in flight or waiting for token of pacer, no coroutine can be resumed anymore
+        if (in_flight.empty() && backlog.empty()) {
+            break;
+        }
+
+        // with only backlog left timeout of window is delay until next token of pacer, token that became available
+        // after windowFull gives no timeout, backlog is sent right away instead of waiting without end
+        int timeout = resolver.windowTimeout();
+        if (timeout < 0 && !backlog.empty()) {
+            timeout = 0;
+        }
+        pollfd fds{};
+        fds.fd = resolver.getSocket();
+        fds.events = POLLIN;
+        StageTimer wait_timer(Stage::Wait);
+        const int ready_fds = poll(&fds, 1, timeout);
+        wait_timer.stop();
+        ResolverStatus status = ResolverStatus::Ok;
+        if (ready_fds > 0 && (fds.revents & POLLIN)) {
+            status = resolver.receive(handle_response, &arena);
+        }
+        if (status == ResolverStatus::Ok) {
+            status = resolver.expire(handle_response);
+        }
+        if (status != ResolverStatus::Ok) {
+            failAll(status);
+        }
+    }
+
+    tasks.clear();
+    return failure;
+}
@@ -0,0 +1,247 @@
+/**
+ * @file async.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of coroutine query API on top of non-blocking resolver, part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include <coroutine>
+#include <exception>
+#include <unordered_map>
+#include <utility>
+
+#include "resolver.h"
+
+/**
+ * @brief Result of awaited query, packet owns its memory and is set only when status is Ok
+ */
+struct QueryResult {
+    ResolverStatus status = ResolverStatus::Ok;
+    optional<DNSPacket> packet;
+};
+
+template<class T>
+class Task;
+
+/**
+ * @brief Promise of Task, awaiting coroutine is resumed when task finishes (symmetric transfer)
+ */
+class TaskPromiseBase {
+public:
+    suspend_always initial_suspend() noexcept {
+        return {};
+    }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept {
+            return false;
+        }
+        template<class Promise>
+        coroutine_handle<> await_suspend(coroutine_handle<Promise> handle) noexcept {
+            const coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept {
+        return {};
+    }
+
+    // library does not use exceptions, exception escaping from task is fatal
+    void unhandled_exception() noexcept {
+        terminate();
+    }
+
+    coroutine_handle<> continuation;
+};
+
+/**
+ * @brief Lazily started coroutine returning T, it starts when awaited or spawned on AsyncResolver
+ */
+template<class T = void>
+class Task {
+public:
+    struct promise_type : TaskPromiseBase {
+        Task get_return_object() {
+            return Task(coroutine_handle<promise_type>::from_promise(*this));
+        }
+        void return_value(T result) {
+            value.emplace(move(result));
+        }
+        optional<T> value;
+    };
+
+    Task(Task&& other) noexcept : handle(exchange(other.handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+    coroutine_handle<> await_suspend(const coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    T await_resume() {
+        return move(*handle.promise().value);
+    }
+
+private:
+    friend class AsyncResolver;
+    explicit Task(const coroutine_handle<promise_type> handle) : handle(handle) {}
+    coroutine_handle<promise_type> handle;
+};
+
+/**
+ * @brief Coroutine without result
+ */
+template<>
+class Task<void> {
+public:
+    struct promise_type : TaskPromiseBase {
+        Task get_return_object() {
+            return Task(coroutine_handle<promise_type>::from_promise(*this));
+        }
+        void return_void() {}
+    };
+
+    Task(Task&& other) noexcept : handle(exchange(other.handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+    coroutine_handle<> await_suspend(const coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    void await_resume() {}
+
+private:
+    friend class AsyncResolver;
+    explicit Task(const coroutine_handle<promise_type> handle) : handle(handle) {}
+    coroutine_handle<promise_type> handle;
+};
+
+class AsyncResolver;
+class QueryGroupAwaitable;
+
+/**
+ * @brief Awaitable query, awaiting coroutine is suspended until response arrives or query is given up
+ */
+class QueryAwaitable {
+public:
+    QueryAwaitable(AsyncResolver& scheduler, DNSQuestion question) : scheduler(scheduler), question(move(question)) {}
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+    void await_suspend(coroutine_handle<> awaiting);
+    QueryResult await_resume() {
+        return move(result);
+    }
+
+private:
+    friend class AsyncResolver;
+    friend class QueryGroupAwaitable;
+    AsyncResolver& scheduler;
+    DNSQuestion question;
+    QueryResult result;
+    coroutine_handle<> waiting;
+    // group which is resumed when all its queries complete
+    QueryGroupAwaitable* group = nullptr;
+};
+
+/**
+ * @brief Awaitable group of queries sent together, awaiting coroutine is resumed when all of them complete
+ */
+class QueryGroupAwaitable {
+public:
+    QueryGroupAwaitable(AsyncResolver& scheduler, const vector<DNSQuestion>& questions);
+
+    bool await_ready() const noexcept {
+        return queries.empty();
+    }
+    void await_suspend(coroutine_handle<> awaiting);
+    vector<QueryResult> await_resume();
+
+private:
+    friend class AsyncResolver;
+    AsyncResolver& scheduler;
+    vector<QueryAwaitable> queries;
+    size_t remaining = 0;
+    coroutine_handle<> waiting;
+};
+
+/**
+ * @brief Scheduler of coroutines awaiting queries, driven by readiness of socket of resolver.
+ * Awaited queries share window of pipelined queries of the resolver, so thousands of queries can be awaited
+ * at once without thread per query. All coroutines are resumed on the thread that calls run
+ */
+class AsyncResolver {
+public:
+    explicit AsyncResolver(Resolver& resolver, size_t window = DEFAULT_WINDOW, bool recursion = true)
+        : resolver(resolver), window(window), recursion(recursion) {}
+    AsyncResolver(const AsyncResolver&) = delete;
+    AsyncResolver& operator=(const AsyncResolver&) = delete;
+
+    QueryAwaitable query(const string& name, RR_TYPE type);
+    QueryAwaitable query(const string& name, uint16_t type, uint16_t class_ = 0x0001);
+    QueryGroupAwaitable queryAll(const vector<DNSQuestion>& questions);
+
+    void spawn(Task<void> task);
+    ResolverStatus run();
+
+private:
+    friend class QueryAwaitable;
+    friend class QueryGroupAwaitable;
+    void submit(QueryAwaitable* query);
+    void complete(QueryAwaitable* query);
+    void failAll(ResolverStatus status);
+
+    Resolver& resolver;
+    size_t window;
+    bool recursion;
+    bool window_open = false;
+    // first error of resolver, later queries complete with it immediately
+    ResolverStatus failure = ResolverStatus::Ok;
+    // responses are parsed in arena and copied into packets owned by awaiting coroutines
+    Arena arena;
+
+    vector<Task<void>> tasks;
+    unordered_map<size_t, QueryAwaitable*> in_flight;
+    deque<QueryAwaitable*> backlog;
+    deque<coroutine_handle<>> ready;
+};
+
+#endif // ASYNC_H
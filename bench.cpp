@@ -0,0 +1,564 @@
+/**
+ * @file bench.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief benchmarks of dns resolver hot paths
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+#include "dns.h"
+#include "arena.h"
+#include "resolvconf.h"
+#include "resolver.h"
+#include "async.h"
+#include "cache.h"
+#include "results.h"
+#include "pipeline.h"
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <csignal>
+#include <sys/wait.h>
+#endif
+
+using namespace std;
+
+// number of heap allocations made by calling thread, counted by replaced operator new
+static thread_local size_t heap_allocations = 0;
+// bytes requested by those allocations
+static thread_local size_t heap_bytes = 0;
+
+void* operator new(const size_t size) {
+    heap_allocations++;
+    heap_bytes += size;
+    if (void* block = malloc(size > 0 ? size : 1)) {
+        return block;
+    }
+    throw bad_alloc();
+}
+
+// GCC sees inlined free of block returned by (not inlined) operator new above and reports mismatch, both use malloc heap
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* block) noexcept {
+    free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    free(block);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+constexpr int BENCH_RESPONSES = 200000;
+constexpr int BENCH_STARTUPS = 2000;
+// forking shell is slow, fewer iterations are enough
+constexpr int BENCH_SUBPROCESSES = 20;
+constexpr int BENCH_QUERIES = 50000;
+constexpr size_t BENCH_WINDOW = 256;
+constexpr int BENCH_CACHE_ENTRIES = 10000;
+constexpr int BENCH_CACHE_LOOKUPS = 1000000;
+// every stored response has its own names (at most 36^3 three character labels), parsed packets of all of them are kept at once
+constexpr int BENCH_STORED_RESPONSES = 40000;
+// packets passed between two threads through queue of pipeline
+constexpr int BENCH_QUEUE_ITEMS = 1000000;
+// chains of coroutine lookups (A and AAAA together, then MX), three queries each
+constexpr int BENCH_ASYNC_LOOKUPS = 10000;
+// pacing limit of coroutine lookups, backlog of queries outlives queries in flight
+constexpr int BENCH_ASYNC_QPS = 20000;
+
+/**
+ * @brief Appends name in wire format (without compression)
+ * @param packet packet to append to
+ * @param name domain name in dot notation
+ */
+static void append_name(vector<uint8_t>& packet, const string& name) {
+    const string dns_name = getNameToDns(name);
+    packet.insert(packet.end(), dns_name.begin(), dns_name.end());
+}
+
+/**
+ * @brief Appends resource record header and data to packet
+ * @param packet packet to append to
+ * @param name owner name (wire format, may be compression pointer)
+ * @param type record type
+ * @param rdata record data in wire format
+ */
+static void append_record(vector<uint8_t>& packet, const vector<uint8_t>& name, const uint16_t type, const vector<uint8_t>& rdata) {
+    packet.insert(packet.end(), name.begin(), name.end());
+    const uint8_t fields[] = {
+        static_cast<uint8_t>(type >> 8), static_cast<uint8_t>(type), 0x00, 0x01, // type, class IN
+        0x00, 0x00, 0x0e, 0x10, // ttl 3600
+        static_cast<uint8_t>(rdata.size() >> 8), static_cast<uint8_t>(rdata.size()),
+    };
+    packet.insert(packet.end(), begin(fields), end(fields));
+    packet.insert(packet.end(), rdata.begin(), rdata.end());
+}
+
+/**
+ * @brief Builds typical recursive response: CNAME chain with addresses, name servers and glue records
+ * @return response packet in wire format
+ */
+static vector<uint8_t> build_response() {
+    const auto id = static_cast<uint16_t>(getpid());
+    vector<uint8_t> packet = {
+        static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id), 0x81, 0x80, // id, flags QR RD RA
+        0x00, 0x01, 0x00, 0x03, 0x00, 0x02, 0x00, 0x02, // qdcount, ancount, nscount, arcount
+    };
+    append_name(packet, "www.example.com");
+    packet.insert(packet.end(), {0x00, 0x01, 0x00, 0x01});
+
+    const vector<uint8_t> question_name = {0xc0, 0x0c};
+    const vector<uint8_t> domain_name = {0xc0, 0x10};
+    append_record(packet, question_name, RR_TYPE::CNAME, {0xc0, 0x10});
+    append_record(packet, domain_name, RR_TYPE::A, {93, 184, 216, 34});
+    append_record(packet, domain_name, RR_TYPE::A, {93, 184, 216, 35});
+
+    vector<uint8_t> ns1 = {3, 'n', 's', '1', 0xc0, 0x10};
+    vector<uint8_t> ns2 = {3, 'n', 's', '2', 0xc0, 0x10};
+    append_record(packet, domain_name, RR_TYPE::NS, ns1);
+    append_record(packet, domain_name, RR_TYPE::NS, ns2);
+
+    vector<uint8_t> glue1, glue2;
+    append_name(glue1, "ns1.example.com");
+    append_name(glue2, "ns2.example.com");
+    append_record(packet, glue1, RR_TYPE::A, {199, 43, 135, 53});
+    append_record(packet, glue2, RR_TYPE::AAAA, {0x20, 0x01, 0x05, 0x00, 0x00, 0x8f, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x53});
+    return packet;
+}
+
+/**
+ * @brief Parses and formats response repeatedly and prints allocations and throughput
+ * @param label name of the benchmark
+ * @param response response packet in wire format
+ * @param arena arena reset after each batch of responses, nullptr to give each response its own memory
+ */
+static void bench_parse_format(const string& label, const vector<uint8_t>& response, Arena* arena) {
+    size_t output_bytes = 0;
+    size_t batched = 0;
+
+    const size_t allocations_before = heap_allocations;
+    const auto start = chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_RESPONSES; i++) {
+        if (arena != nullptr && batched++ == ARENA_BATCH_SIZE) {
+            arena->reset();
+            batched = 1;
+        }
+        const DNSPacket packet(response.data(), response.size(), arena);
+        pmr::string out(packet.getResource());
+        dns_format(packet, out);
+        output_bytes += out.size();
+    }
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    const size_t allocations = heap_allocations - allocations_before;
+
+    cout << "  " << setw(24) << left << label
+         << setw(14) << left << fixed << setprecision(2) << static_cast<double>(allocations) / BENCH_RESPONSES
+         << setw(16) << left << setprecision(0) << BENCH_RESPONSES / elapsed.count()
+         << setprecision(1) << elapsed.count() * 1e9 / BENCH_RESPONSES << " ns" << endl;
+
+    if (output_bytes == 0) {
+        cout << "  (no output formatted)" << endl;
+    }
+}
+
+/**
+ * @brief Looks up cached responses from several threads at once and prints throughput of all threads
+ * @param cache cache filled with BENCH_CACHE_ENTRIES entries
+ * @param keys keys of cached entries
+ * @param threads number of reading threads
+ */
+static void bench_cache_lookups(AnswerCache& cache, const vector<string>& keys, const unsigned threads) {
+    vector<thread> readers;
+    const auto start = chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; t++) {
+        readers.emplace_back([&cache, &keys, t] {
+            vector<uint8_t> response;
+            bool prefetch;
+            size_t key = t * 7919;
+            for (int i = 0; i < BENCH_CACHE_LOOKUPS; i++) {
+                key = (key + 104729) % keys.size();
+                cache.lookup(keys[key], response, prefetch);
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    const double lookups = static_cast<double>(BENCH_CACHE_LOOKUPS) * threads;
+    cout << "  " << setw(24) << left << threads << setw(16) << left << fixed << setprecision(0) << lookups / elapsed.count()
+         << setprecision(1) << elapsed.count() * 1e9 * threads / lookups << " ns" << endl;
+}
+
+/**
+ * @brief Measures lookups of sharded answer cache with growing number of reading threads
+ * @param response response packet stored under every key
+ */
+static void bench_cache(const vector<uint8_t>& response) {
+    AnswerCache cache;
+    vector<string> keys;
+    const DNSPacket packet(response.data(), response.size());
+    for (int i = 0; i < BENCH_CACHE_ENTRIES; i++) {
+        keys.push_back(AnswerCache::key(DNSQuestion("host" + to_string(i) + ".example.com", RR_TYPE::A)));
+        cache.insert(keys.back(), packet);
+    }
+
+    cout << "Answer cache lookups, " << cache.size() << " entries (" << cache.memory() / 1024 << " KiB), "
+         << BENCH_CACHE_LOOKUPS << " lookups per thread (" << thread::hardware_concurrency() << " cores)" << endl;
+    cout << "  " << setw(24) << left << "threads" << setw(16) << left << "lookups/s" << "time/lookup of thread" << endl;
+    for (const unsigned threads : {1u, 2u, 4u}) {
+        bench_cache_lookups(cache, keys, threads);
+    }
+}
+
+/**
+ * @brief Keeps many responses as parsed packets and in columnar result store and prints memory and time of both
+ * @param response response packet in wire format, queried name starts with label www
+ */
+static void bench_results(const vector<uint8_t>& response) {
+    // label www of queried name is replaced by unique label of each response
+    const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    vector<vector<uint8_t>> responses(BENCH_STORED_RESPONSES, response);
+    for (int i = 0; i < BENCH_STORED_RESPONSES; i++) {
+        uint8_t* label = responses[i].data() + sizeof(WireHeader) + 1;
+        label[0] = digits[i / (36 * 36)];
+        label[1] = digits[i / 36 % 36];
+        label[2] = digits[i % 36];
+    }
+
+    cout << "Kept results, " << BENCH_STORED_RESPONSES << " responses (7 records, 3 answers each)" << endl;
+    cout << "  " << setw(24) << left << "mode" << setw(14) << left << "bytes/resp" << setw(16) << left << "resp/s" << "time/resp" << endl;
+    const auto print = [](const string& label, const size_t bytes, const chrono::duration<double> elapsed) {
+        cout << "  " << setw(24) << left << label << setw(14) << left << bytes / BENCH_STORED_RESPONSES
+             << setw(16) << left << fixed << setprecision(0) << BENCH_STORED_RESPONSES / elapsed.count()
+             << setprecision(1) << elapsed.count() * 1e9 / BENCH_STORED_RESPONSES << " ns" << endl;
+    };
+
+    {
+        vector<DNSPacket> packets;
+        packets.reserve(responses.size());
+        const size_t bytes_before = heap_bytes;
+        const auto start = chrono::steady_clock::now();
+        for (const auto& stored : responses) {
+            packets.emplace_back(stored.data(), stored.size());
+        }
+        print("parsed packets", heap_bytes - bytes_before, chrono::steady_clock::now() - start);
+    }
+    {
+        ResultStore store;
+        Arena arena;
+        size_t batched = 0;
+        const auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < responses.size(); i++) {
+            if (batched++ == ARENA_BATCH_SIZE) {
+                arena.reset();
+                batched = 1;
+            }
+            store.add(static_cast<uint32_t>(i), DNSPacket(responses[i].data(), responses[i].size(), &arena));
+        }
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        // columns are mapped outside of heap, parsed packets are only temporary
+        print("columnar store", store.getMemory(), elapsed);
+
+        const auto scan_start = chrono::steady_clock::now();
+        const size_t groups = store.groupByRdata(RESULTS_SUMMARY_GROUPS).size();
+        const uint64_t short_ttls = store.ttlHistogram()[0];
+        const size_t chains = store.cnameChains().size();
+        const chrono::duration<double> scan = chrono::steady_clock::now() - scan_start;
+        cout << "  aggregations of " << store.getRecords() << " records (" << groups << " groups, " << chains
+             << " chains): " << setprecision(1) << scan.count() * 1e3 << " ms" << (short_ttls > 0 ? " (TTL 0 seen)" : "") << endl;
+    }
+}
+
+/**
+ * @brief Passes copies of response from producer thread to consumer thread through SPSC queue of pipeline,
+ * prints throughput and heap allocations of both threads (slots keep their buffers, so only the first use allocates)
+ * @param response response packet in wire format
+ */
+static void bench_pipeline(const vector<uint8_t>& response) {
+    struct Packet {
+        vector<uint8_t> bytes;
+    };
+    SpscRing<Packet> queue(PIPELINE_QUEUE_SIZE, Queue::Parse);
+    size_t consumer_allocations = 0;
+    size_t received_bytes = 0;
+
+    const auto start = chrono::steady_clock::now();
+    thread consumer([&] {
+        while (queue.pop([&](const Packet& packet) { received_bytes += packet.bytes.size(); })) {
+        }
+        consumer_allocations = heap_allocations;
+    });
+    const size_t allocations_before = heap_allocations;
+    for (int i = 0; i < BENCH_QUEUE_ITEMS; i++) {
+        queue.push([&](Packet& packet) { packet.bytes.assign(response.begin(), response.end()); });
+    }
+    queue.close();
+    const size_t producer_allocations = heap_allocations - allocations_before;
+    consumer.join();
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    cout << "Pipeline queue, " << BENCH_QUEUE_ITEMS << " packets of " << response.size() << " B between two threads ("
+         << PIPELINE_QUEUE_SIZE << " slots, " << thread::hardware_concurrency() << " cores)" << endl;
+    cout << "  " << setw(24) << left << "allocs total" << setw(16) << left << "packets/s" << "time/packet" << endl;
+    cout << "  " << setw(24) << left << producer_allocations + consumer_allocations << setw(16) << left << fixed << setprecision(0)
+         << BENCH_QUEUE_ITEMS / elapsed.count() << setprecision(1) << elapsed.count() * 1e9 / BENCH_QUEUE_ITEMS << " ns"
+         << (received_bytes == response.size() * BENCH_QUEUE_ITEMS ? "" : " (packets lost)") << endl;
+}
+
+/**
+ * @brief Measures average time of startup step and prints it
+ * @param label name of the step
+ * @param iterations number of repetitions
+ * @param step measured step
+ */
+template<class Step>
+static void bench_startup_step(const string& label, const int iterations, Step step) {
+    const auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        step();
+    }
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "  " << setw(40) << left << label << fixed << setprecision(1) << elapsed.count() * 1e6 / iterations << " us" << endl;
+}
+
+/**
+ * @brief Measures steps of program startup before the first query: system configuration and server address,
+ * each lookup with cache file starts with reading the file like a new process does
+ */
+static void bench_startup() {
+    const string cache_path = "dns-bench.cache";
+    ResolverConfig config;
+    vector<ServerAddress> addresses;
+    string error;
+
+    cout << "Cold start (per run), " << BENCH_STARTUPS << " iterations" << endl;
+    bench_startup_step("parse " + string(RESOLV_CONF_PATH), BENCH_STARTUPS, [&] {
+        ResolverConfig parsed;
+        parsed.parseFile(RESOLV_CONF_PATH);
+    });
+    bench_startup_step("load system config", BENCH_STARTUPS, [&] {
+        resolver_config_load(config);
+    });
+    bench_startup_step("server address 127.0.0.1", BENCH_STARTUPS, [&] {
+        server_address_lookup("127.0.0.1", 53, addresses, error);
+    });
+    resolver_cache_open("");
+    bench_startup_step("server address localhost, no cache", BENCH_STARTUPS / 10, [&] {
+        server_address_lookup("localhost", 53, addresses, error);
+    });
+    resolver_cache_open(cache_path);
+    server_address_lookup("localhost", 53, addresses, error);
+    bench_startup_step("server address localhost, cache file", BENCH_STARTUPS, [&] {
+        resolver_cache_open(cache_path);
+        server_address_lookup("localhost", 53, addresses, error);
+    });
+#if !defined(_WIN32) && !defined(_WIN64)
+    bench_startup_step("subprocess via popen (removed fallback)", BENCH_SUBPROCESSES, [] {
+        if (FILE* pipe = popen("true", "r")) {
+            pclose(pipe);
+        }
+    });
+#endif
+    resolver_cache_open("");
+    remove(cache_path.c_str());
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+/**
+ * @brief Mock server answering every query by the query itself with QR flag, runs in child process until it is killed
+ * @param server_fd bound UDP socket
+ */
+[[noreturn]] static void run_mock_server(const int server_fd) {
+    uint8_t packet[BUFFER_SIZE];
+    sockaddr_storage client{};
+    while (true) {
+        socklen_t client_length = sizeof(client);
+        const ssize_t length = recvfrom(server_fd, packet, sizeof(packet), 0, reinterpret_cast<sockaddr*>(&client), &client_length);
+        if (length < static_cast<ssize_t>(sizeof(WireHeader))) {
+            continue;
+        }
+        WireHeader* header = reinterpret_cast<WireHeader*>(packet);
+        header->flags = static_cast<uint16_t>(header->flags | 0x8080);
+        sendto(server_fd, packet, static_cast<size_t>(length), 0, reinterpret_cast<const sockaddr*>(&client), client_length);
+    }
+}
+
+/**
+ * @brief Resolves questions in bulk mode against mock server on loopback with given backend and prints throughput
+ * @param label name of the backend
+ * @param port port of mock server
+ * @param io_uring use io_uring backend
+ */
+static void bench_backend(const string& label, const uint16_t port, const bool io_uring) {
+    Resolver resolver;
+    resolver.setIoUring(io_uring);
+    if (resolver.open("127.0.0.1", port) != ResolverStatus::Ok) {
+        cout << "  " << label << ": " << resolver.getError() << endl;
+        return;
+    }
+    int next = 0;
+    size_t answered = 0;
+    const auto next_question = [&](DNSQuestion& question) {
+        if (next == BENCH_QUERIES) {
+            return false;
+        }
+        question = DNSQuestion("q" + to_string(next++) + ".bench.example", RR_TYPE::A);
+        return true;
+    };
+    const auto handle_response = [&](size_t, const DNSQuestion&, const DNSPacket* response) {
+        answered += response != nullptr ? 1 : 0;
+    };
+
+    Arena arena;
+    const auto start = chrono::steady_clock::now();
+    const ResolverStatus status = resolver.sendWindow(next_question, handle_response, false, BENCH_WINDOW, &arena);
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "  " << setw(24) << left << (label + (io_uring && !resolver.usesIoUring() ? " (socket)" : ""))
+         << setw(12) << left << answered << setw(16) << left << fixed << setprecision(0) << BENCH_QUERIES / elapsed.count()
+         << setprecision(2) << elapsed.count() * 1e6 / BENCH_QUERIES << " us";
+    if (status != ResolverStatus::Ok) {
+        cout << " (" << resolver_status_string(status) << ")";
+    }
+    cout << endl;
+}
+
+/**
+ * @brief Counts of chains of coroutine lookups by their result
+ */
+struct AsyncCounts {
+    size_t answered = 0;
+    size_t failed = 0;
+};
+
+/**
+ * @brief Lookup of name by coroutine: A and AAAA awaited together, then MX,
+ * chain stops at first query that did not get response
+ * @param scheduler scheduler of coroutines
+ * @param name looked up name
+ * @param counts counts of chains
+ */
+static Task<void> bench_async_lookup(AsyncResolver& scheduler, const string name, AsyncCounts& counts) {
+    vector<DNSQuestion> questions;
+    questions.emplace_back(name, RR_TYPE::A);
+    questions.emplace_back(name, RR_TYPE::AAAA);
+    const vector<QueryResult> addresses = co_await scheduler.queryAll(questions);
+    for (const QueryResult& result : addresses) {
+        if (result.status != ResolverStatus::Ok) {
+            counts.failed++;
+            co_return;
+        }
+    }
+    const QueryResult mail = co_await scheduler.query(name, RR_TYPE::MX);
+    if (mail.status != ResolverStatus::Ok) {
+        counts.failed++;
+        co_return;
+    }
+    counts.answered++;
+}
+
+/**
+ * @brief Runs chains of coroutine lookups against mock server and prints throughput,
+ * with resolver that is not open every chain has to complete with the failure of resolver
+ * @param label name of the case
+ * @param port port of mock server, 0 leaves resolver closed
+ * @param qps limit of queries per second, 0 is unlimited (with limit queries wait for token of pacer with nothing in flight)
+ */
+static void bench_async(const string& label, const uint16_t port, const double qps) {
+    Resolver resolver;
+    PacingConfig pacing;
+    pacing.qps = qps;
+    resolver.setPacing(pacing);
+    if (port != 0 && resolver.open("127.0.0.1", port) != ResolverStatus::Ok) {
+        cout << "  " << label << ": " << resolver.getError() << endl;
+        return;
+    }
+    AsyncResolver scheduler(resolver, BENCH_WINDOW, false);
+    AsyncCounts counts;
+    for (int i = 0; i < BENCH_ASYNC_LOOKUPS; i++) {
+        scheduler.spawn(bench_async_lookup(scheduler, "a" + to_string(i) + ".bench.example", counts));
+    }
+
+    const auto start = chrono::steady_clock::now();
+    const ResolverStatus status = scheduler.run();
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "  " << setw(24) << left << label << setw(12) << left << counts.answered << setw(12) << left << counts.failed
+         << setw(16) << left << fixed << setprecision(0) << BENCH_ASYNC_LOOKUPS / elapsed.count()
+         << setprecision(2) << elapsed.count() * 1e6 / BENCH_ASYNC_LOOKUPS << " us";
+    if (status != ResolverStatus::Ok) {
+        cout << " (" << resolver_status_string(status) << ")";
+    }
+    cout << endl;
+}
+
+/**
+ * @brief Compares socket and io_uring backend of bulk mode and coroutine lookups against mock server on loopback
+ */
+static void bench_backends() {
+    const int server_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    const int buffer = 1 << 22;
+    setsockopt(server_fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+    if (server_fd == -1 || bind(server_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == -1 ||
+        getsockname(server_fd, reinterpret_cast<sockaddr*>(&address), &length) == -1) {
+        cout << "Mock server cannot be started" << endl;
+        return;
+    }
+    const pid_t server = fork();
+    if (server == 0) {
+        run_mock_server(server_fd);
+    }
+    close(server_fd);
+
+    cout << "Bulk queries on loopback mock server, " << BENCH_QUERIES << " queries, window " << BENCH_WINDOW << endl;
+    cout << "  " << setw(24) << left << "backend" << setw(12) << left << "answered" << setw(16) << left << "queries/s" << "time/query" << endl;
+    bench_backend("socket", ntohs(address.sin_port), false);
+    bench_backend("io_uring", ntohs(address.sin_port), true);
+
+    cout << "Coroutine lookups on loopback mock server, " << BENCH_ASYNC_LOOKUPS << " chains of A + AAAA, then MX, window "
+         << BENCH_WINDOW << endl;
+    cout << "  " << setw(24) << left << "resolver" << setw(12) << left << "answered" << setw(12) << left << "failed"
+         << setw(16) << left << "chains/s" << "time/chain" << endl;
+    bench_async("open", ntohs(address.sin_port), 0);
+    bench_async("open, " + to_string(BENCH_ASYNC_QPS) + " queries/s", ntohs(address.sin_port), BENCH_ASYNC_QPS);
+    bench_async("not open (failure)", 0, 0);
+
+    kill(server, SIGKILL);
+    waitpid(server, nullptr, 0);
+}
+#endif
+
+int main() {
+    const vector<uint8_t> response = build_response();
+
+    cout << "Parse + format of response (" << response.size() << " B, 7 records), " << BENCH_RESPONSES << " iterations" << endl;
+    cout << "  " << setw(24) << left << "mode" << setw(14) << left << "allocs/resp" << setw(16) << left << "resp/s" << "time/resp" << endl;
+    bench_parse_format("per-response memory", response, nullptr);
+    Arena arena;
+    bench_parse_format("shared arena (batch " + to_string(ARENA_BATCH_SIZE) + ")", response, &arena);
+
+    bench_cache(response);
+    bench_results(response);
+    bench_pipeline(response);
+    bench_startup();
+#if !defined(_WIN32) && !defined(_WIN64)
+    bench_backends();
+#endif
+
+    return 0;
+}
@@ -0,0 +1,425 @@
+/**
+ * @file cache.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of sharded concurrent in-memory TTL cache of dns responses
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "cache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+
+using namespace std;
+
+// type of EDNS pseudo record, its TTL field holds flags
+constexpr uint16_t RR_TYPE_OPT = 41;
+
+/**
+ * @brief Epoch announced by thread while it reads entries without lock, 0 when it does not read
+ */
+struct alignas(64) ReaderSlot {
+    atomic<uint64_t> epoch{0};
+    atomic<bool> taken{false};
+};
+
+// epoch of reclamation, advanced whenever entry is unlinked (shared by all caches)
+static atomic<uint64_t> global_epoch{1};
+static ReaderSlot reader_slots[CACHE_MAX_READERS];
+
+/**
+ * @brief Reader slot of thread, claimed by its first lookup and released when thread exits
+ */
+struct ReaderHandle {
+    ReaderSlot* slot = nullptr;
+
+    ReaderHandle() {
+        for (auto& candidate : reader_slots) {
+            bool expected = false;
+            if (candidate.taken.compare_exchange_strong(expected, true)) {
+                slot = &candidate;
+                return;
+            }
+        }
+    }
+    ~ReaderHandle() {
+        if (slot != nullptr) {
+            slot->taken.store(false, memory_order_release);
+        }
+    }
+};
+
+static thread_local ReaderHandle reader;
+
+/**
+ * @brief Read-side critical section, entries seen inside of it are not freed until it ends.
+ * Thread without reader slot reads under lock of shard instead
+ */
+class ReadGuard {
+public:
+    explicit ReadGuard(mutex& shard_mutex) {
+        if (reader.slot == nullptr) {
+            lock = unique_lock<mutex>(shard_mutex);
+            return;
+        }
+        reader.slot->epoch.store(global_epoch.load());
+        // announced epoch is visible to writers before any entry is read (pairs with fence in reclaim)
+        atomic_thread_fence(memory_order_seq_cst);
+    }
+    ~ReadGuard() {
+        if (reader.slot != nullptr) {
+            reader.slot->epoch.store(0, memory_order_release);
+        }
+    }
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+
+private:
+    unique_lock<mutex> lock;
+};
+
+/**
+ * @brief Current time of steady clock
+ * @return nanoseconds since epoch of steady clock
+ */
+static int64_t steady_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Creates empty cache, memory budget is split evenly between shards
+ * @param memory_budget memory of entries in bytes, least recently used entries are evicted above it
+ * @param prefetch_percent entries hit within this last percent of their TTL are marked for prefetch (0 disables prefetch)
+ * @param prefetch_rate minimum hits per minute of entries marked for prefetch
+ */
+AnswerCache::AnswerCache(const size_t memory_budget, const unsigned prefetch_percent, const unsigned prefetch_rate)
+    : shard_budget(max<size_t>(1, memory_budget / CACHE_SHARDS)), prefetch_percent(prefetch_percent), prefetch_rate(prefetch_rate) {
+    size_t buckets = 16;
+    while (buckets < shard_budget / CACHE_ENTRY_ESTIMATE) {
+        buckets <<= 1;
+    }
+    for (auto& shard : shards) {
+        shard.buckets = vector<atomic<Entry*>>(buckets);
+    }
+}
+
+/**
+ * @brief Frees all entries, no thread may read the cache anymore
+ */
+AnswerCache::~AnswerCache() {
+    for (auto& shard : shards) {
+        for (auto& bucket : shard.buckets) {
+            Entry* entry = bucket.load(memory_order_relaxed);
+            while (entry != nullptr) {
+                Entry* next = entry->next.load(memory_order_relaxed);
+                delete entry;
+                entry = next;
+            }
+        }
+        for (const auto& retired : shard.retired) {
+            delete retired.first;
+        }
+    }
+}
+
+/**
+ * @brief Builds cache key of question: lowercase name without trailing dot, type and class
+ * @param question question of query
+ * @return cache key
+ */
+string AnswerCache::key(const DNSQuestion& question) {
+    const pmr::string& name = question.getName();
+    string key;
+    key.reserve(name.length() + 5);
+    for (const char c : name) {
+        key += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    if (!key.empty() && key.back() == '.') {
+        key.pop_back();
+    }
+    key += '/';
+    key += static_cast<char>(question.getType() >> 8);
+    key += static_cast<char>(question.getType() & 0xff);
+    key += static_cast<char>(question.getClass() >> 8);
+    key += static_cast<char>(question.getClass() & 0xff);
+    return key;
+}
+
+/**
+ * @brief Case insensitive hash of cache key (FNV-1a), low bits select shard and high bits bucket
+ * @param key cache key of question
+ * @return 64-bit hash
+ */
+uint64_t AnswerCache::hash(const string& key) {
+    uint64_t value = 0xcbf29ce484222325;
+    for (const char c : key) {
+        value ^= static_cast<uint8_t>(tolower(static_cast<unsigned char>(c)));
+        value *= 0x100000001b3;
+    }
+    return value;
+}
+
+/**
+ * @brief Computes how long response can be cached: minimum TTL of answers, for negative answers
+ * minimum of SOA TTL and SOA minimum field (RFC 2308)
+ * @param response response from server
+ * @param cacheable set to false when response must not be cached (error, truncated or without TTL source)
+ * @return TTL in seconds
+ */
+uint32_t AnswerCache::responseTtl(const DNSPacket& response, bool& cacheable) {
+    const DNSHeader& header = response.getHeader();
+    const uint16_t rcode = header.getRcode();
+    cacheable = (rcode == 0 || rcode == 3) && !(header.getFlags() & DNSHeader::FLAGS::TC) && !response.isMalformed();
+
+    uint32_t ttl = CACHE_MAX_TTL;
+    if (rcode == 0 && !response.getAnswers().empty()) {
+        for (const auto& record : response.getAnswers()) {
+            ttl = min(ttl, record.getTtl());
+        }
+        return ttl;
+    }
+
+    for (const auto& record : response.getAuthorities()) {
+        if (record.getTypeValue() == RR_TYPE::SOA && record.getRdlength() >= sizeof(WireSoa)) {
+            const auto* fields = reinterpret_cast<const WireSoa*>(record.getRdataBytes() + record.getRdlength() - sizeof(WireSoa));
+            return min({ttl, record.getTtl(), static_cast<uint32_t>(fields->minimum)});
+        }
+    }
+
+    cacheable = false;
+    return 0;
+}
+
+/**
+ * @brief Shard of entry with given hash
+ * @param hash hash of key
+ * @return shard
+ */
+AnswerCache::Shard& AnswerCache::shardOf(const uint64_t hash) {
+    return shards[hash & (CACHE_SHARDS - 1)];
+}
+
+/**
+ * @brief Finds entry of key in its bucket, caller is inside of read-side critical section or holds lock of shard
+ * @param shard shard of key
+ * @param hash hash of key
+ * @param key cache key of question
+ * @return entry or nullptr
+ */
+AnswerCache::Entry* AnswerCache::find(Shard& shard, const uint64_t hash, const string& key) const {
+    Entry* entry = shard.buckets[(hash >> 32) & (shard.buckets.size() - 1)].load(memory_order_acquire);
+    while (entry != nullptr && (entry->hash != hash || entry->key != key)) {
+        entry = entry->next.load(memory_order_acquire);
+    }
+    return entry;
+}
+
+/**
+ * @brief Records unlinked entry, it is freed by reclaim after readers that could see it have finished
+ * @param shard shard of entry, its lock is held
+ * @param entry unlinked entry
+ */
+void AnswerCache::retire(Shard& shard, Entry* entry) {
+    shard.bytes.store(shard.bytes.load(memory_order_relaxed) - entry->bytes, memory_order_relaxed);
+    shard.retired.emplace_back(entry, global_epoch.fetch_add(1));
+}
+
+/**
+ * @brief Sweeps buckets by clock hand, one bucket on every insert to drop expired entries, and more while shard
+ * is over its memory budget. Over budget entry not hit since the hand passed it last time is evicted (CLOCK,
+ * approximation of least recently used)
+ * @param shard shard, its lock is held
+ * @param now current time
+ */
+void AnswerCache::evict(Shard& shard, const int64_t now) {
+    do {
+        const bool over_budget = shard.bytes.load(memory_order_relaxed) > shard_budget;
+        atomic<Entry*>* link = &shard.buckets[shard.hand];
+        Entry* entry;
+        while ((entry = link->load(memory_order_relaxed)) != nullptr) {
+            if (entry->expires > now && (!over_budget || entry->referenced.exchange(false, memory_order_relaxed))) {
+                link = &entry->next;
+                continue;
+            }
+            // readers inside of entry still follow its next pointer, it stays valid until entry is freed
+            link->store(entry->next.load(memory_order_relaxed), memory_order_release);
+            shard.entries.fetch_sub(1, memory_order_relaxed);
+            retire(shard, entry);
+        }
+        shard.hand = (shard.hand + 1) & (shard.buckets.size() - 1);
+    } while (shard.bytes.load(memory_order_relaxed) > shard_budget && shard.entries.load(memory_order_relaxed) > 0);
+}
+
+/**
+ * @brief Frees retired entries unlinked before the oldest epoch announced by readers
+ * @param shard shard, its lock is held
+ */
+void AnswerCache::reclaim(Shard& shard) {
+    if (shard.retired.empty()) {
+        return;
+    }
+    // unlinking is visible to readers before their epochs are read (pairs with fence in ReadGuard)
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t oldest = UINT64_MAX;
+    for (const auto& slot : reader_slots) {
+        const uint64_t epoch = slot.epoch.load(memory_order_acquire);
+        if (epoch != 0) {
+            oldest = min(oldest, epoch);
+        }
+    }
+    // reader that announced epoch later than unlinking cannot reach the entry
+    const auto freed = remove_if(shard.retired.begin(), shard.retired.end(), [&](const pair<Entry*, uint64_t>& retired) {
+        if (retired.second >= oldest) {
+            return false;
+        }
+        delete retired.first;
+        return true;
+    });
+    shard.retired.erase(freed, shard.retired.end());
+}
+
+/**
+ * @brief Finds valid response for key without locking, TTLs of its records are decreased by age of the entry.
+ * Entry hit within last prefetch_percent of its lifetime with at least prefetch_rate hits per minute
+ * is marked for prefetch once, caller refreshes it while the cached response is still served
+ * @param key cache key of question
+ * @param response output packet in wire format (ID and question are those of original query)
+ * @param prefetch set to true when caller should refresh the entry
+ * @return true if response was found
+ */
+bool AnswerCache::lookup(const string& key, vector<uint8_t>& response, bool& prefetch) {
+    prefetch = false;
+    const uint64_t key_hash = hash(key);
+    Shard& shard = shardOf(key_hash);
+    const ReadGuard guard(shard.mutex);
+    Entry* entry = find(shard, key_hash, key);
+    const int64_t now = steady_ns();
+    // expired entry is dropped by clock hand or replaced by response of new query
+    if (entry == nullptr || entry->expires <= now) {
+        return false;
+    }
+    // reference bit and hits are written only while they change, hot entry stays shared in caches of all cores
+    if (!entry->referenced.load(memory_order_relaxed)) {
+        entry->referenced.store(true, memory_order_relaxed);
+    }
+
+    if (prefetch_percent > 0 && !entry->prefetching.load(memory_order_relaxed)) {
+        uint64_t hits = entry->hits.load(memory_order_relaxed);
+        if (hits < entry->hits_needed) {
+            hits = entry->hits.fetch_add(1, memory_order_relaxed) + 1;
+        }
+        const int64_t lifetime = (entry->expires - entry->inserted) / 1000000;
+        const int64_t remaining = (entry->expires - now) / 1000000;
+        const int64_t elapsed = max<int64_t>((now - entry->inserted) / 1000000, 1);
+        if (remaining * 100 <= lifetime * prefetch_percent && hits * 60000 >= prefetch_rate * static_cast<uint64_t>(elapsed) &&
+            !entry->prefetching.exchange(true, memory_order_relaxed)) {
+            prefetch = true;
+        }
+    }
+
+    const auto age = static_cast<uint32_t>((now - entry->inserted) / 1000000000);
+    response = entry->packet;
+    for (const auto& [offset, original] : entry->ttls) {
+        const uint32_t ttl = original > age ? original - age : 0;
+        *reinterpret_cast<BigEndian<uint32_t>*>(response.data() + offset) = ttl;
+    }
+    return true;
+}
+
+/**
+ * @brief Allows entry to be marked for prefetch again after its refresh failed
+ * @param key cache key of question
+ */
+void AnswerCache::prefetchFailed(const string& key) {
+    const uint64_t key_hash = hash(key);
+    Shard& shard = shardOf(key_hash);
+    const ReadGuard guard(shard.mutex);
+    Entry* entry = find(shard, key_hash, key);
+    if (entry != nullptr) {
+        entry->prefetching.store(false, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Stores response when it is cacheable, entry expires with the lowest TTL of the response.
+ * Entry of the same key is replaced, readers see either old or new entry
+ * @param key cache key of question
+ * @param response response from server
+ */
+void AnswerCache::insert(const string& key, const DNSPacket& response) {
+    bool cacheable;
+    const uint32_t ttl = responseTtl(response, cacheable);
+    if (!cacheable || ttl == 0) {
+        return;
+    }
+
+    // entry is built before lock is taken
+    auto* entry = new Entry();
+    entry->hash = hash(key);
+    entry->key = key;
+    entry->packet.assign(response.getRaw(), response.getRaw() + response.getRawLength());
+    for (const auto* section : {&response.getAnswers(), &response.getAuthorities(), &response.getAdditionals()}) {
+        for (const auto& record : *section) {
+            if (record.getTypeValue() != RR_TYPE_OPT) {
+                entry->ttls.emplace_back(static_cast<uint16_t>(record.getTtlOffset()), record.getTtl());
+            }
+        }
+    }
+    entry->inserted = steady_ns();
+    entry->expires = entry->inserted + static_cast<int64_t>(ttl) * 1000000000;
+    entry->hits_needed = (static_cast<uint64_t>(prefetch_rate) * ttl + 59) / 60;
+    entry->bytes = sizeof(Entry) + entry->key.capacity() + entry->packet.capacity() + entry->ttls.capacity() * sizeof(entry->ttls[0]);
+    if (entry->bytes > shard_budget) {
+        delete entry;
+        return;
+    }
+
+    Shard& shard = shardOf(entry->hash);
+    const lock_guard<mutex> lock(shard.mutex);
+    atomic<Entry*>* link = &shard.buckets[(entry->hash >> 32) & (shard.buckets.size() - 1)];
+    Entry* current;
+    while ((current = link->load(memory_order_relaxed)) != nullptr && (current->hash != entry->hash || current->key != key)) {
+        link = &current->next;
+    }
+    if (current != nullptr) {
+        entry->next.store(current->next.load(memory_order_relaxed), memory_order_relaxed);
+        link->store(entry, memory_order_release);
+        retire(shard, current);
+    } else {
+        // new entry is published at head of bucket after it is complete
+        atomic<Entry*>& head = shard.buckets[(entry->hash >> 32) & (shard.buckets.size() - 1)];
+        entry->next.store(head.load(memory_order_relaxed), memory_order_relaxed);
+        head.store(entry, memory_order_release);
+        shard.entries.fetch_add(1, memory_order_relaxed);
+    }
+    shard.bytes.fetch_add(entry->bytes, memory_order_relaxed);
+
+    evict(shard, entry->inserted);
+    reclaim(shard);
+}
+
+/**
+ * @brief Number of entries, expired entries not yet swept included
+ * @return number of entries
+ */
+size_t AnswerCache::size() const {
+    size_t entries = 0;
+    for (const auto& shard : shards) {
+        entries += shard.entries.load(memory_order_relaxed);
+    }
+    return entries;
+}
+
+/**
+ * @brief Memory of entries accounted against budget
+ * @return bytes of entries
+ */
+size_t AnswerCache::memory() const {
+    size_t bytes = 0;
+    for (const auto& shard : shards) {
+        bytes += shard.bytes.load(memory_order_relaxed);
+    }
+    return bytes;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file cache.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of sharded concurrent in-memory TTL cache of dns responses
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dns.h"
+
+// memory of cached responses (keys, packets and TTL fields), least recently used entries are evicted above it
+constexpr size_t CACHE_MEMORY_BUDGET = 64 << 20;
+// upper limit of time a response is kept, regardless of TTL of its records
+constexpr uint32_t CACHE_MAX_TTL = 86400;
+// entry hit within last percent of its TTL is refreshed in background (0 disables prefetch)
+constexpr unsigned CACHE_PREFETCH_PERCENT = 10;
+// minimum hits per minute since entry was stored for the entry to be refreshed
+constexpr unsigned CACHE_PREFETCH_RATE = 6;
+// independent shards with their own lock of writers (power of two)
+constexpr size_t CACHE_SHARDS = 16;
+// expected memory of one entry, sets number of hash buckets of shard
+constexpr size_t CACHE_ENTRY_ESTIMATE = 256;
+// threads reading without lock at the same time, further threads read under lock of shard
+constexpr size_t CACHE_MAX_READERS = 64;
+
+/**
+ * @brief Cache of complete responses keyed by question, records are served with TTL decreased by their age,
+ * popular entries close to expiration are marked for prefetch.
+ * Entries are spread over shards by hash of key, each shard has its own lock taken only by writers.
+ * Readers never lock: entries are immutable after insertion and published by atomic pointer, replaced or evicted entry
+ * is freed only after all readers that could see it have finished (epoch based reclamation, RCU)
+ */
+class AnswerCache {
+public:
+    explicit AnswerCache(size_t memory_budget = CACHE_MEMORY_BUDGET, unsigned prefetch_percent = CACHE_PREFETCH_PERCENT,
+                         unsigned prefetch_rate = CACHE_PREFETCH_RATE);
+    ~AnswerCache();
+    AnswerCache(const AnswerCache&) = delete;
+    AnswerCache& operator=(const AnswerCache&) = delete;
+
+    static std::string key(const DNSQuestion& question);
+    static uint64_t hash(const std::string& key);
+    static uint32_t responseTtl(const DNSPacket& response, bool& cacheable);
+
+    bool lookup(const std::string& key, std::vector<uint8_t>& response, bool& prefetch);
+    void insert(const std::string& key, const DNSPacket& response);
+    void prefetchFailed(const std::string& key);
+
+    size_t size() const;
+    size_t memory() const;
+
+private:
+    /**
+     * @brief Cached response, only hits, prefetch flag and reference bit change after it is published
+     */
+    struct Entry {
+        uint64_t hash = 0;
+        std::string key;
+        std::vector<uint8_t> packet;
+        // offsets of TTL fields in packet and their original values
+        std::vector<std::pair<uint16_t, uint32_t>> ttls;
+        // absolute times of steady clock in nanoseconds
+        int64_t inserted = 0;
+        int64_t expires = 0;
+        size_t bytes = 0;
+        std::atomic<Entry*> next{nullptr};
+        // hits are counted up to the number that satisfies prefetch rate over whole lifetime,
+        // so popular entries are not written by every lookup
+        std::atomic<uint64_t> hits{0};
+        uint64_t hits_needed = 0;
+        std::atomic<bool> prefetching{false};
+        // set by hit, cleared by clock hand, entry without it is evicted
+        std::atomic<bool> referenced{true};
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::vector<std::atomic<Entry*>> buckets;
+        // next bucket visited by clock hand
+        size_t hand = 0;
+        // changed only under lock, read without it by size and memory
+        std::atomic<size_t> bytes{0};
+        std::atomic<size_t> entries{0};
+        // unlinked entries and epoch when they were unlinked, freed when no reader is older
+        std::vector<std::pair<Entry*, uint64_t>> retired;
+    };
+
+    Shard& shardOf(uint64_t hash);
+    Entry* find(Shard& shard, uint64_t hash, const std::string& key) const;
+    void retire(Shard& shard, Entry* entry);
+    void evict(Shard& shard, int64_t now);
+    void reclaim(Shard& shard);
+
+    size_t shard_budget;
+    unsigned prefetch_percent;
+    unsigned prefetch_rate;
+    Shard shards[CACHE_SHARDS];
+};
+
+#endif // CACHE_H
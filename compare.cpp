@@ -0,0 +1,265 @@
+/**
+ * @file compare.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of benchmark comparing upstream resolvers on the same queries
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "compare.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <memory>
+#include <unordered_map>
+
+#include "stats.h"
+
+using namespace std;
+
+// response codes counted separately, others are counted together
+static constexpr int COMPARE_RCODES = 6;
+static const char* const rcode_names[COMPARE_RCODES] = {"NOERROR", "FORMERR", "SERVFAIL", "NXDOMAIN", "NOTIMP", "REFUSED"};
+
+/**
+ * @brief Resolver of one compared server and its results
+ */
+struct CompareServer {
+    string name;
+    Resolver resolver;
+    StageHistogram latency;
+    uint64_t answered = 0;
+    uint64_t timeouts = 0;
+    uint64_t rcodes[COMPARE_RCODES + 1] = {};
+    // query of each index of the resolver
+    unordered_map<size_t, size_t> in_flight;
+};
+
+/**
+ * @brief Answers of query from all servers, kept until all of them respond
+ */
+struct CompareResult {
+    size_t remaining = 0;
+    bool timeout = false;
+    vector<string> answers;
+};
+
+/**
+ * @brief Canonical form of response for comparison: response code and sorted answer records
+ * (lower case name, type and data), TTLs and order of records are ignored
+ * @param response response packet
+ * @return canonical answer set
+ */
+static string answer_set(const DNSPacket& response) {
+    vector<string> records;
+    records.reserve(response.getAnswers().size());
+    for (const auto& record : response.getAnswers()) {
+        string text(record.getNameView());
+        transform(text.begin(), text.end(), text.begin(), [](const unsigned char c) {
+            return static_cast<char>(tolower(c));
+        });
+        text += ' ';
+        text += record.getType();
+        text += ' ';
+        record.appendRdata(text);
+        records.push_back(move(text));
+    }
+    sort(records.begin(), records.end());
+
+    const uint16_t rcode = response.getHeader().getRcode();
+    string set = rcode < COMPARE_RCODES ? rcode_names[rcode] : "RCODE " + to_string(rcode);
+    for (const auto& record : records) {
+        set += records.size() > 1 ? "\n        " : " ";
+        set += record;
+    }
+    return set;
+}
+
+/**
+ * @brief Prints per-server latency percentiles, timeout rate and response codes
+ * @param servers compared servers
+ * @param queries number of queries sent to each server
+ */
+static void print_report(const vector<unique_ptr<CompareServer>>& servers, const size_t queries) {
+    size_t width = 6;
+    for (const auto& server : servers) {
+        width = max(width, server->name.length());
+    }
+    cout << "Comparison of " << servers.size() << " servers, " << queries << " queries each" << endl;
+    cout << "  " << setw(static_cast<int>(width)) << left << "server" << right << setw(10) << "answered"
+         << setw(10) << "timeout %" << setw(10) << "p50 ms" << setw(10) << "p90 ms" << setw(10) << "p99 ms" << setw(10) << "max ms";
+    for (const char* rcode : rcode_names) {
+        cout << setw(10) << rcode;
+    }
+    cout << setw(10) << "other" << endl;
+
+    cout << fixed;
+    for (const auto& server : servers) {
+        const double timeout_rate = queries > 0 ? 100.0 * static_cast<double>(server->timeouts) / static_cast<double>(queries) : 0.0;
+        cout << "  " << setw(static_cast<int>(width)) << left << server->name << right << setw(10) << server->answered
+             << setw(10) << setprecision(1) << timeout_rate << setprecision(3)
+             << setw(10) << static_cast<double>(server->latency.percentile(0.50)) / 1e6
+             << setw(10) << static_cast<double>(server->latency.percentile(0.90)) / 1e6
+             << setw(10) << static_cast<double>(server->latency.percentile(0.99)) / 1e6
+             << setw(10) << static_cast<double>(server->latency.getMax()) / 1e6;
+        for (const uint64_t count : server->rcodes) {
+            cout << setw(10) << count;
+        }
+        cout << endl;
+    }
+    cout << defaultfloat;
+}
+
+/**
+ * @brief Sends every query to every server and compares their latency, timeouts, response codes and answers.
+ * Each query is sent to all servers at once (starting server rotates), so servers share network conditions,
+ * each server has its own window of queries in flight, lost queries are retransmitted
+ * @param servers IP addresses or hostnames of compared servers
+ * @param port port of servers
+ * @param queries questions sent to each server
+ * @param window maximum number of queries in flight per server
+ * @param recursion recursion desired
+ * @param configure sets options of resolver of each server (pacing, timestamps, backend) before it is opened
+ * @param error details of server that cannot be opened
+ * @return Ok or error of first failed resolver
+ */
+ResolverStatus dns_compare(const vector<string>& servers, const uint16_t port, const vector<CompareQuery>& queries,
+                           const size_t window, const bool recursion, const function<void(Resolver& resolver)>& configure, string& error) {
+    vector<unique_ptr<CompareServer>> compared;
+    for (const auto& name : servers) {
+        compared.push_back(make_unique<CompareServer>());
+        CompareServer& server = *compared.back();
+        server.name = name;
+        configure(server.resolver);
+        // every server numbers its queries from 1, scope keeps their trace events apart
+        server.resolver.setTraceScope(static_cast<uint32_t>(compared.size()));
+        ResolverStatus status = server.resolver.open(name, port);
+        if (status == ResolverStatus::Ok) {
+            status = server.resolver.openWindow(window);
+        }
+        if (status != ResolverStatus::Ok) {
+            error = name + " - " + server.resolver.getError();
+            return status;
+        }
+    }
+
+    unordered_map<size_t, CompareResult> results;
+    size_t compared_queries = 0;
+    size_t disagreements = 0;
+
+    auto complete = [&](const size_t query, const size_t server, const DNSPacket* response) {
+        CompareResult& result = results[query];
+        if (result.answers.empty()) {
+            result.answers.resize(compared.size());
+        }
+        if (response != nullptr) {
+            result.answers[server] = answer_set(*response);
+        } else {
+            result.timeout = true;
+        }
+        if (--result.remaining > 0) {
+            return;
+        }
+
+        // answers are compared only when all servers responded
+        if (!result.timeout) {
+            compared_queries++;
+            const bool agree = all_of(result.answers.begin(), result.answers.end(), [&](const string& answer) {
+                return answer == result.answers[0];
+            });
+            if (!agree && ++disagreements <= COMPARE_MAX_EXAMPLES) {
+                cout << "Disagreement: " << queries[query].name << " " << RR_TYPE::typeToString(static_cast<uint16_t>(queries[query].type)) << endl;
+                for (size_t i = 0; i < compared.size(); i++) {
+                    cout << "    " << compared[i]->name << ": " << result.answers[i] << endl;
+                }
+            }
+        }
+        results.erase(query);
+    };
+
+    vector<ResponseHandler> handlers;
+    for (size_t i = 0; i < compared.size(); i++) {
+        handlers.emplace_back([&, i](const size_t index, const DNSQuestion&, const DNSPacket* response) {
+            CompareServer& server = *compared[i];
+            const auto it = server.in_flight.find(index);
+            if (it == server.in_flight.end()) {
+                return;
+            }
+            const size_t query = it->second;
+            server.in_flight.erase(it);
+            if (response != nullptr) {
+                server.answered++;
+                // from the first transmission to receipt (kernel timestamp when enabled), retransmissions included
+                server.latency.record(server.resolver.getResponseTime());
+                server.rcodes[min<int>(response->getHeader().getRcode(), COMPARE_RCODES)]++;
+            } else {
+                server.timeouts++;
+            }
+            complete(query, i, response);
+        });
+    }
+
+    Arena arena;
+    vector<pollfd> fds(compared.size());
+    size_t next_query = 0;
+    while (true) {
+        // Next query is sent when every server has free slot, so all servers get it at the same time
+        while (next_query < queries.size() && none_of(compared.begin(), compared.end(), [](const auto& server) {
+                   return server->resolver.windowFull();
+               })) {
+            const DNSQuestion question(queries[next_query].name, queries[next_query].type);
+            results[next_query].remaining = compared.size();
+            for (size_t n = 0; n < compared.size(); n++) {
+                CompareServer& server = *compared[(next_query + n) % compared.size()];
+                size_t index;
+                const ResolverStatus status = server.resolver.submit(question, recursion, index);
+                server.in_flight[index] = next_query;
+                if (status != ResolverStatus::Ok) {
+                    error = server.name + " - " + resolver_status_string(status);
+                    return status;
+                }
+            }
+            next_query++;
+        }
+
+        if (next_query == queries.size() && results.empty()) {
+            break;
+        }
+
+        int timeout = -1;
+        for (size_t i = 0; i < compared.size(); i++) {
+            fds[i] = pollfd{};
+            fds[i].fd = compared[i]->resolver.getSocket();
+            fds[i].events = POLLIN;
+            const int server_timeout = compared[i]->resolver.windowTimeout();
+            if (server_timeout >= 0 && (timeout < 0 || server_timeout < timeout)) {
+                timeout = server_timeout;
+            }
+        }
+        StageTimer wait_timer(Stage::Wait);
+        const int ready = poll(fds.data(), static_cast<nfds_t>(fds.size()), timeout);
+        wait_timer.stop();
+        if (ready < 0) {
+            continue;
+        }
+
+        for (size_t i = 0; i < compared.size(); i++) {
+            CompareServer& server = *compared[i];
+            ResolverStatus status = ResolverStatus::Ok;
+            if (fds[i].revents & POLLIN) {
+                status = server.resolver.receive(handlers[i], &arena);
+            }
+            if (status == ResolverStatus::Ok) {
+                status = server.resolver.expire(handlers[i]);
+            }
+            if (status != ResolverStatus::Ok) {
+                error = server.name + " - " + resolver_status_string(status);
+                return status;
+            }
+        }
+    }
+
+    print_report(compared, queries.size());
+    cout << "Disagreements: " << disagreements << " of " << compared_queries << " queries answered by all servers" << endl;
+    return ResolverStatus::Ok;
+}
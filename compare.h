@@ -0,0 +1,31 @@
+/**
+ * @file compare.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of benchmark comparing upstream resolvers on the same queries
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef COMPARE_H
+#define COMPARE_H
+
+#include <string>
+#include <vector>
+
+#include "resolver.h"
+
+// disagreements printed with answers of all servers, the rest is only counted
+constexpr size_t COMPARE_MAX_EXAMPLES = 10;
+
+/**
+ * @brief Query of comparison, question is sent to every server
+ */
+struct CompareQuery {
+    string name;
+    RR_TYPE type;
+};
+
+ResolverStatus dns_compare(const vector<string>& servers, uint16_t port, const vector<CompareQuery>& queries,
+                           size_t window, bool recursion, const function<void(Resolver& resolver)>& configure, string& error);
+
+#endif // COMPARE_H
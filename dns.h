@@ -15,10 +15,14 @@
 #include <string>
 #include <cstring>
 #include <cstdint>
-#include <csignal>
 #include <memory>
+#include <memory_resource>
+#include <functional>
+#include <string_view>
 
 #include "error.h"
+#include "arena.h"
+#include "wire.h"
 
 #if defined(_WIN32) || defined(_WIN64) // windows
 
@@ -30,6 +34,7 @@
 #pragma comment(lib, "iphlpapi.lib")
 
 #define close(a) (void)closesocket(a)
+#define poll(a, b, c) WSAPoll(a, b, c)
 #define socklen_t int
 
 #else // unix
@@ -40,6 +45,7 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <unistd.h>
+#include <poll.h>
 #include <fstream>
 
 #endif // _WIN32 || _WIN64
@@ -51,21 +57,6 @@ constexpr int MAX_RESPONSE_WAIT_SEC = 10;
 // according to RFC 1035, the maximum size of a UDP datagram is 512 bytes, but some DNS servers can send larger responses
 constexpr int BUFFER_SIZE = 4096;
 
-inline uint16_t test_value = 0x01;
-inline bool is_little_endian = (*reinterpret_cast<uint8_t*>(&test_value)) == 0x01;
-inline uint16_t htonse(const uint16_t value) {
-    return is_little_endian ? htons(value) : value;
-}
-inline uint16_t ntohse(const uint16_t value) {
-    return is_little_endian ? ntohs(value) : value;
-}
-inline uint32_t htonle(const uint32_t value) {
-    return is_little_endian ? htonl(value) : value;
-}
-inline uint32_t ntohle(const uint32_t value) {
-    return is_little_endian ? ntohl(value) : value;
-}
-
 inline bool is_compressed(const uint8_t byte) {
     return (byte & 0xc0) == 0xc0;
 }
@@ -73,46 +64,126 @@ inline uint16_t get_compressed_offset(const uint8_t* buffer) {
     return (static_cast<uint16_t>(buffer[0] & 0x3f) << 8) | buffer[1];
 }
 
-inline string getNameToDot(const uint8_t* buffer) {
-    string name;
+// maximum length of domain name in wire format (RFC 1035 section 2.3.4)
+constexpr size_t MAX_NAME_LENGTH = 255;
+// maximum number of compression pointers followed in one name, protects against pointer loops
+constexpr int MAX_NAME_POINTERS = 32;
 
-    while (buffer[0] != 0) {
-        name += string(reinterpret_cast<const char*>(buffer + 1), buffer[0]);
-        buffer += buffer[0] + 1;
-        if (buffer[0] != 0) {
-            name += ".";
-            //pointer to another name
-            if (is_compressed(buffer[0])) { 
-                name += static_cast<char>(buffer[0]);
-                name += static_cast<char>(buffer[1]);
-                break;
-            }
+/**
+ * @brief Fixed capacity character buffer used to decode names without heap allocation
+ */
+class NameBuffer {
+public:
+    void append(const char* data, size_t length) {
+        if (length > sizeof(text) - size_) {
+            length = sizeof(text) - size_;
         }
+        memcpy(text + size_, data, length);
+        size_ += length;
     }
 
-    return name;
-}
+    NameBuffer& operator+=(const char c) {
+        append(&c, 1);
+        return *this;
+    }
 
-inline string getNameToDotRef(const uint8_t* buffer, const uint8_t* packet) {
-    string name = getNameToDot(buffer);
+    size_t size() const {
+        return size_;
+    }
 
-    if (is_compressed(name[name.length() - 2])) {
-        const uint16_t name_offset = get_compressed_offset(reinterpret_cast<const uint8_t *>(name.c_str()) + name.length() - 2);
-        name = name.substr(0, name.length() - 2);
-        name += getNameToDot(packet + name_offset);
+    const char* data() const {
+        return text;
     }
 
-    return name;
-}
+private:
+    char text[MAX_NAME_LENGTH + 1] = "";
+    size_t size_ = 0;
+};
 
-inline size_t getNameToDotRefLength(const uint8_t* buffer) {
-    string name = getNameToDot(buffer);
+/**
+ * @brief Appends name at buffer in dot notation (without trailing dot), compression pointers are followed inside packet
+ * @param out string (or NameBuffer) to append to
+ * @param buffer start of the name in wire format
+ * @param packet start of the packet, used to resolve compression pointers
+ * @param end end of the packet, name is never read past it
+ * @return number of bytes occupied by the name at buffer, 0 when the name exceeds the packet
+ */
+template <class String>
+size_t appendNameToDot(String& out, const uint8_t* buffer, const uint8_t* packet, const uint8_t* end) {
+    size_t length = 0;
+    bool jumped = false;
+    bool first = true;
+    int pointers = 0;
+
+    while (true) {
+        if (buffer >= end) {
+            return 0;
+        }
+        if (buffer[0] == 0) {
+            break;
+        }
+        //pointer to another name
+        if (is_compressed(buffer[0])) {
+            if (end - buffer < 2) {
+                return 0;
+            }
+            if (!jumped) {
+                length += sizeof(uint16_t);
+                jumped = true;
+            }
+            if (packet == nullptr || ++pointers > MAX_NAME_POINTERS) {
+                break;
+            }
+            buffer = packet + get_compressed_offset(buffer);
+            continue;
+        }
+        if (end - buffer <= buffer[0]) {
+            return 0;
+        }
 
-    if (is_compressed(name[name.length() - 2])) {
-        return name.length();
+        if (!first) {
+            out += '.';
+        }
+        first = false;
+        out.append(reinterpret_cast<const char*>(buffer + 1), buffer[0]);
+        if (!jumped) {
+            length += buffer[0] + 1;
+        }
+        buffer += buffer[0] + 1;
     }
 
-    return name.length() + 2;
+    return jumped ? length : length + 1;
+}
+
+/**
+ * @brief Appends unsigned number in decimal notation
+ * @param out string to append to
+ * @param value number to append
+ */
+template <class String>
+void appendNumber(String& out, const uint32_t value) {
+    char digits[10];
+    char* first = digits + sizeof(digits);
+    uint32_t rest = value;
+    do {
+        *--first = static_cast<char>('0' + rest % 10);
+        rest /= 10;
+    } while (rest != 0);
+    out.append(first, static_cast<size_t>(digits + sizeof(digits) - first));
+}
+
+/**
+ * @brief Appends text and pads it with spaces to width (left aligned column)
+ * @param out string to append to
+ * @param text text to append
+ * @param width minimal width of the column
+ */
+template <class String>
+void appendPadded(String& out, const string_view text, const size_t width) {
+    out.append(text.data(), text.size());
+    if (text.size() < width) {
+        out.append(width - text.size(), ' ');
+    }
 }
 
 inline string getNameToDns(const string& address) {
@@ -153,12 +224,6 @@ inline string getInverseName(const string& address) {
     // Convert address from text to binary IPv4 address to reversed ARPA order
     in_addr ipv4{};
     if (inet_pton(AF_INET, address.c_str(), &ipv4) == 1) {
-        char reverseArpa[INET_ADDRSTRLEN];
-        if (inet_ntop(AF_INET, &ipv4, reverseArpa, sizeof(reverseArpa)) == nullptr) {
-            warning_print("Error converting address back to ASCII characters");
-            return "in-addr.arpa";
-        }
-
         // Reverse the order of the octets
         string name;
         for (int i = 3; i >= 0; --i) {
@@ -172,12 +237,6 @@ inline string getInverseName(const string& address) {
     // Convert address from text to binary IPv6 address to reversed ARPA order
     in6_addr ipv6{};
     if (inet_pton(AF_INET6, address.c_str(), &ipv6) == 1) {
-        char reverseArpa[INET6_ADDRSTRLEN];
-        if (inet_ntop(AF_INET6, &ipv6, reverseArpa, sizeof(reverseArpa)) == nullptr) {
-            warning_print("Error converting address back to ASCII characters");
-            return "ip6.arpa";
-        }
-
         // 48 offset for ASCII 0-9, 87 offset for ASCII a-f
         // Reverse the order of the octets
         string name;
@@ -191,7 +250,7 @@ inline string getInverseName(const string& address) {
         return name+"ip6.arpa";
     }
 
-    warning_print("Address '"+address+"' is not valid IPv4 or IPv6 address");
+    // address is not valid IPv4 or IPv6 address, caller checks for root name and reports it
     return ".";
 }
 
@@ -206,6 +265,8 @@ public:
         MX = 0x000f,
         TXT = 0x0010,
         AAAA = 0x001c,
+        IXFR = 0x00fb,
+        AXFR = 0x00fc,
         ANY = 0x00ff,
     };
 
@@ -235,6 +296,10 @@ public:
                 return "TXT";
             case AAAA:
                 return "AAAA";
+            case IXFR:
+                return "IXFR";
+            case AXFR:
+                return "AXFR";
             case ANY:
                 return "ANY";
             default:
@@ -246,98 +311,105 @@ private:
     Type type;
 };
 
+// called with text of warning, library reports warnings through it instead of printing them
+using WarningHandler = function<void(const string& message)>;
+
 class DNSHeader {
 public:
     DNSHeader() = default;
 
-    DNSHeader(const bool recursion) {
-        this->id = static_cast<uint16_t>(getpid());
+    DNSHeader(const bool recursion, const uint16_t id = static_cast<uint16_t>(getpid())) {
+        this->id = id;
         this->flags = recursion ? RD : 0;
         this->qdcount = 1;
     }
 
-    DNSHeader(const uint8_t* buffer) {
-        memcpy(&id, buffer, sizeof(uint16_t));
-        memcpy(&flags, buffer + sizeof(uint16_t), sizeof(uint16_t));
-        memcpy(&qdcount, buffer + 2 * sizeof(uint16_t), sizeof(uint16_t));
-        memcpy(&ancount, buffer + 3 * sizeof(uint16_t), sizeof(uint16_t));
-        memcpy(&nscount, buffer + 4 * sizeof(uint16_t), sizeof(uint16_t));
-        memcpy(&arcount, buffer + 5 * sizeof(uint16_t), sizeof(uint16_t));
-        this->id = ntohse(id);
-        this->flags = ntohse(flags);
-        this->qdcount = ntohse(qdcount);
-        this->ancount = ntohse(ancount);
-        this->nscount = ntohse(nscount);
-        this->arcount = ntohse(arcount);
-
-        if (this->id != static_cast<uint16_t>(getpid())) {
-            warning_print("ID of response packet does not match ID of request packet");
-        }
+    DNSHeader(const WireHeader& wire) :
+        id(wire.id),
+        flags(wire.flags),
+        qdcount(wire.qdcount),
+        ancount(wire.ancount),
+        nscount(wire.nscount),
+        arcount(wire.arcount) {}
+
+    /**
+     * @brief Reads header at start of packet, packet must be at least sizeof(WireHeader) bytes long
+     */
+    DNSHeader(const uint8_t* buffer) : DNSHeader(*reinterpret_cast<const WireHeader*>(buffer)) {}
+
+    uint16_t getId() const {
+        return id;
+    }
+
+    uint16_t getFlags() const {
+        return flags;
+    }
+
+    uint16_t getQdcount() const {
+        return qdcount;
+    }
+
+    uint16_t getAncount() const {
+        return ancount;
+    }
+
+    uint16_t getNscount() const {
+        return nscount;
+    }
 
+    uint16_t getArcount() const {
+        return arcount;
+    }
+
+    uint16_t getRcode() const {
+        return flags & RCODE_MASK;
+    }
+
+    /**
+     * @brief Reports warning when packet is not response or response code reports error
+     * @param warn handler of warnings (program prints them to stderr)
+     */
+    void reportWarnings(const WarningHandler& warn) const {
         if (!(flags & QR_RESPONSE)) {
-            warning_print("Request packet received");
+            warn("Request packet received");
         }
 
         switch (flags & RCODE_MASK) {
             case 0:
                 break;
             case 1:
-                warning_print("Format error - The name server was unable to interpret the query.");
+                warn("Format error - The name server was unable to interpret the query.");
                 break;
             case 2:
-                warning_print("Server failure - The name server was unable to process this query due to a problem with the name server.");
+                warn("Server failure - The name server was unable to process this query due to a problem with the name server.");
                 break;
             case 3:
-                warning_print("Name error - The domain name referenced in the query does not exist.");
+                warn("Name error - The domain name referenced in the query does not exist.");
                 break;
             case 4:
-                warning_print("Not implemented - The name server does not support the requested kind of query.");
+                warn("Not implemented - The name server does not support the requested kind of query.");
                 break;
             case 5:
-                warning_print("Refused - The name server refuses to perform the specified operation for policy reasons.");
+                warn("Refused - The name server refuses to perform the specified operation for policy reasons.");
                 break;
             case 6:
-                warning_print("YXDomain - Name exists when it should not.");
+                warn("YXDomain - Name exists when it should not.");
                 break;
             case 7:
-                warning_print("YXRRSet - RR set exists when it should not.");
+                warn("YXRRSet - RR set exists when it should not.");
                 break;
             case 8:
-                warning_print("NotAuth - Server not authoritative for zone.");
+                warn("NotAuth - Server not authoritative for zone.");
                 break;
             case 9:
-                warning_print("NotZone - Name not contained in zone.");
+                warn("NotZone - Name not contained in zone.");
                 break;
             default:
-                warning_print("Unknown error");
+                warn("Unknown error");
                 break;
         }
     }
 
-    uint16_t getId() const {
-        return id;
-    }
-
-    uint16_t getFlags() const {
-        return flags;
-    }
-
-    uint16_t getQdcount() const {
-        return qdcount;
-    }
-
-    uint16_t getAncount() const {
-        return ancount;
-    }
-
-    uint16_t getNscount() const {
-        return nscount;
-    }
-
-    uint16_t getArcount() const {
-        return arcount;
-    }
-
     enum FLAGS {
         QR_RESPONSE = 0x8000,
         OP_STATUS = 0x1000,
@@ -362,22 +434,56 @@ class DNSQuestion {
 public:
     DNSQuestion() = default;
 
+    explicit DNSQuestion(pmr::memory_resource* arena) : name(arena) {}
+
     DNSQuestion(const string& address, const RR_TYPE type) :
         name(type == RR_TYPE::Type::PTR ? getInverseName(address) : address),
         type(type),
         class_(0x0001) {}
 
-    DNSQuestion(const uint8_t* buffer) :
-        name(getNameToDot(buffer)),
-        type(ntohse(*reinterpret_cast<const uint16_t*>(buffer + name.length() + (name.empty() ? 1 : 2)))),
-        class_(ntohse(*reinterpret_cast<const uint16_t*>(buffer + name.length() + (name.empty() ? 3 : 4)))) {}
+    DNSQuestion(const string& name, const uint16_t type, const uint16_t class_) :
+        name(name),
+        type(type),
+        class_(class_) {}
+
+    /**
+     * @brief Parses question at cursor, name is allocated in arena
+     * @param reader cursor at start of question, invalid when question exceeds packet
+     * @param arena memory resource of name
+     */
+    DNSQuestion(WireReader& reader, pmr::memory_resource* arena) : name(arena) {
+        NameBuffer text;
+        const size_t start = reader.getOffset();
+        const size_t offset = appendNameToDot(text, reader.getPosition(), nullptr, reader.getEnd());
+        const WireQuestion* fields = offset > 0 && reader.skip(offset) ? reader.view<WireQuestion>() : nullptr;
+        if (fields == nullptr) {
+            reader.fail();
+            return;
+        }
+        this->name.assign(text.data(), text.size());
+        this->type = fields->type;
+        this->class_ = fields->class_;
+        this->questionLength = reader.getOffset() - start;
+    }
 
     string getNameDot() const {
-        return this->name[this->name.length() - 1] == '.' ? this->name : this->name + ".";
+        string name_dot(this->name);
+        if (name_dot.empty() || name_dot[name_dot.length() - 1] != '.') {
+            name_dot += '.';
+        }
+        return name_dot;
+    }
+
+    const pmr::string& getName() const {
+        return name;
     }
 
     string getNameDns() const {
-        return getNameToDns(this->name);
+        return getNameToDns(string(this->name));
+    }
+
+    size_t getQuestionLength() const {
+        return questionLength;
     }
 
     uint16_t getType() const {
@@ -393,6 +499,10 @@ public:
     }
 
     string getClassString() const {
+        return classToString(class_);
+    }
+
+    static string classToString(const uint16_t class_) {
         switch (class_) {
             case 0x0001:
                 return "IN";
@@ -408,50 +518,47 @@ public:
     }
 
 private:
-    string name;
+    pmr::string name;
     uint16_t type = 0;
     uint16_t class_ = 0;
+
+    size_t questionLength = 0;
 };
 
 class DNSRecord {
 public:
     DNSRecord() = default;
 
-    DNSRecord(const uint8_t* buffer, const uint8_t* packet) {
-        this->packet = packet;
-        size_t offset = 0;
-
-        if (buffer[0] == 0x00) {
-            this->name = "";
-            offset += sizeof(uint8_t);
-        } else if (is_compressed(buffer[0])) {
-            this->name = getNameToDotRef(packet + get_compressed_offset(buffer), this->packet);
-            offset += sizeof(uint16_t);
-        } else {
-            this->name = getNameToDot(buffer);
-            offset += this->name.length() + 2;
+    /**
+     * @brief Parses record at cursor, record data are not copied and point into the packet
+     * @param reader cursor at start of record in packet, invalid when record exceeds packet
+     * @param arena memory resource of name
+     */
+    DNSRecord(WireReader& reader, pmr::memory_resource* arena) {
+        this->packet = reader.getData();
+        this->packetEnd = reader.getEnd();
+        const size_t start = reader.getOffset();
+
+        // Decode name on stack and keep only its exact copy in the arena
+        NameBuffer text;
+        const size_t offset = appendNameToDot(text, reader.getPosition(), packet, packetEnd);
+        const WireRecord* fields = offset > 0 && reader.skip(offset) ? reader.view<WireRecord>() : nullptr;
+        if (fields == nullptr || !reader.skip(fields->rdlength)) {
+            reader.fail();
+            return;
         }
+        char* name_data = static_cast<char*>(arena->allocate(text.size() + 1, 1));
+        memcpy(name_data, text.data(), text.size());
+        name_data[text.size()] = '.';
+        this->name = string_view(name_data, text.size() + 1);
 
-        memcpy(&type, buffer + offset, sizeof(uint16_t));
-        this->type = ntohse(type);
-        offset += sizeof(uint16_t);
-
-        memcpy(&class_, buffer + offset, sizeof(uint16_t));
-        this->class_ = ntohse(class_);
-        offset += sizeof(uint16_t);
-
-        memcpy(&ttl, buffer + offset, sizeof(uint32_t));
-        this->ttl = ntohle(ttl);
-        offset += sizeof(uint32_t);
-
-        memcpy(&rdlength, buffer + offset, sizeof(uint16_t));
-        this->rdlength = ntohse(rdlength);
-        offset += sizeof(uint16_t);
-
-        this->rdata = string(reinterpret_cast<const char*>(buffer + offset), rdlength);
-        offset += rdlength;
-
-        this->recordLength = offset;
+        this->type = fields->type;
+        this->class_ = fields->class_;
+        this->ttl = fields->ttl;
+        this->rdlength = fields->rdlength;
+        this->ttlOffset = start + offset + offsetof(WireRecord, ttl);
+        this->rdata = reader.getPosition() - rdlength;
+        this->recordLength = reader.getOffset() - start;
     }
 
     size_t getRecordLength() const {
@@ -459,26 +566,27 @@ public:
     }
 
     string getName() const {
-        return name + ".";
+        return string(name);
+    }
+
+    string_view getNameView() const {
+        return name;
     }
 
     string getType() const {
         return RR_TYPE::typeToString(type);
     }
 
+    uint16_t getTypeValue() const {
+        return type;
+    }
+
     string getClass() const {
-        switch (class_) {
-            case 0x0001:
-                return "IN";
-            case 0x0002:
-                return "CS";
-            case 0x0003:
-                return "CH";
-            case 0x0004:
-                return "HS";
-            default:
-                return "UNKNOWN";
-        }
+        return DNSQuestion::classToString(class_);
+    }
+
+    uint16_t getClassValue() const {
+        return class_;
     }
 
     uint32_t getTtl() const {
@@ -489,101 +597,123 @@ public:
         return rdlength;
     }
 
+    const uint8_t* getRdataBytes() const {
+        return rdata;
+    }
+
+    size_t getTtlOffset() const {
+        return ttlOffset;
+    }
+
     string getRdata() const {
-        in6_addr ipv6{};
         string result;
+        appendRdata(result);
+        return result;
+    }
+
+    /**
+     * @brief Checks whether data of record can be formatted
+     * @return warning about invalid length of data, nullptr when data is valid
+     */
+    const char* getRdataWarning() const {
+        string result;
+        return appendRdata(result);
+    }
+
+    /**
+     * @brief Appends data of record in text form, data of invalid length is appended as is or cut
+     * @param result output string
+     * @return warning about invalid length of data, nullptr when data is valid
+     */
+    template <class String>
+    const char* appendRdata(String& result) const {
+        const char* raw = reinterpret_cast<const char*>(rdata);
         size_t offset;
         switch (type) {
             case RR_TYPE::A:
                 if (rdlength != 4) {
-                    warning_print("A record has invalid length");
-                    return rdata;
+                    result.append(raw, rdlength);
+                    return "A record has invalid length";
                 }
                 for (int i = 0; i < rdlength; i++) {
-                    // Convert each octet to ASCII character
-                    result += to_string(static_cast<uint8_t>(rdata[i]));
+                    // Convert each octet to ASCII characters
+                    appendNumber(result, rdata[i]);
                     if (i != rdlength - 1) {
-                        result += ".";
+                        result += '.';
                     }
                 }
                 break;
-            case RR_TYPE::AAAA:
+            case RR_TYPE::AAAA: {
                 if (rdlength != 16) {
-                    warning_print("AAAA record has invalid length");
-                    return rdata;
+                    result.append(raw, rdlength);
+                    return "AAAA record has invalid length";
                 }
-                for (int i = 0; i < rdlength; i += 2) {
-                    // 48 offset for ASCII 0-9, 87 offset for ASCII a-f
-                    // Convert each octet to ASCII characters
-                    result += static_cast<char>((rdata[i] >> 4 & 0xF) + ((rdata[i] >> 4 & 0xF) > 9 ? 87 : 48));
-                    result += static_cast<char>((rdata[i] & 0xF) + ((rdata[i] & 0xF) > 9 ? 87 : 48));
-                    result += static_cast<char>((rdata[i+1] >> 4 & 0xF) + ((rdata[i+1] >> 4 & 0xF) > 9 ? 87 : 48));
-                    result += static_cast<char>((rdata[i+1] & 0xF) + ((rdata[i+1] & 0xF) > 9 ? 87 : 48));
-                    if (i != rdlength - 2) {
-                        result += ":";
-                    }
+                // Convert address directly to shortened form
+                char address[INET6_ADDRSTRLEN];
+                if (inet_ntop(AF_INET6, rdata, address, sizeof(address)) != nullptr) {
+                    result.append(address, strlen(address));
+                }
+                break;
+            }
+            case RR_TYPE::SOA: {
+                offset = appendNameToDot(result, rdata, this->packet, packetEnd);
+                result.append(". ", 2);
+                const size_t rname = offset > 0 ? appendNameToDot(result, rdata + offset, this->packet, packetEnd) : 0;
+                result.append(". ", 2);
+                offset += rname;
+                if (rname == 0 || offset > rdlength || rdlength - offset < sizeof(WireSoa)) {
+                    return "SOA record has invalid length";
                 }
-                // Convert expanded IPv6 address to shortened form
-                if (inet_pton(AF_INET6, result.c_str(), &ipv6) == 1) {
-                    char address[INET6_ADDRSTRLEN];
-                    if (inet_ntop(AF_INET6, &ipv6, address, sizeof(address)) == nullptr) {
-                        break;
+                const WireSoa* fields = reinterpret_cast<const WireSoa*>(rdata + offset);
+                for (const auto* field : {&fields->serial, &fields->refresh, &fields->retry, &fields->expire, &fields->minimum}) {
+                    appendNumber(result, *field);
+                    if (field != &fields->minimum) {
+                        result += ' ';
                     }
-                    result = string(address);
                 }
                 break;
-            case RR_TYPE::SOA:
-                result += getNameToDotRef(reinterpret_cast<const uint8_t*>(rdata.c_str()), this->packet);
-                result += ". ";
-                offset = getNameToDotRefLength(reinterpret_cast<const uint8_t*>(rdata.c_str()));
-                result += getNameToDotRef(reinterpret_cast<const uint8_t*>(rdata.c_str()) + offset, this->packet);
-                result += ". ";
-                offset += getNameToDotRefLength(reinterpret_cast<const uint8_t*>(rdata.c_str()) + offset);
-                result += to_string(ntohle(*reinterpret_cast<const uint32_t*>(rdata.c_str() + offset)));
-                result += " ";
-                offset += 4;
-                result += to_string(ntohle(*reinterpret_cast<const uint32_t*>(rdata.c_str() + offset)));
-                result += " ";
-                offset += 4;
-                result += to_string(ntohle(*reinterpret_cast<const uint32_t*>(rdata.c_str() + offset)));
-                result += " ";
-                offset += 4;
-                result += to_string(ntohle(*reinterpret_cast<const uint32_t*>(rdata.c_str() + offset)));
-                result += " ";
-                offset += 4;
-                result += to_string(ntohle(*reinterpret_cast<const uint32_t*>(rdata.c_str() + offset)));
-                break;
+            }
             case RR_TYPE::PTR: case RR_TYPE::NS: case RR_TYPE::CNAME:
-                result += getNameToDotRef(reinterpret_cast<const uint8_t*>(rdata.c_str()), this->packet);
-                result += ".";
+                appendNameToDot(result, rdata, this->packet, packetEnd);
+                result += '.';
                 break;
             case RR_TYPE::MX:
-                result += to_string(ntohse(*reinterpret_cast<const uint16_t*>(rdata.c_str())));
-                result += " ";
-                result += getNameToDotRef(reinterpret_cast<const uint8_t*>(rdata.c_str()) + 2, this->packet);
-                result += ".";
+                if (rdlength < sizeof(uint16_t) + 1) {
+                    return "MX record has invalid length";
+                }
+                appendNumber(result, *reinterpret_cast<const BigEndian<uint16_t>*>(rdata));
+                result += ' ';
+                appendNameToDot(result, rdata + sizeof(uint16_t), this->packet, packetEnd);
+                result += '.';
                 break;
             case RR_TYPE::TXT:
-                result += "\"";
-                result += rdata.substr(1, rdata[0]);
-                result += "\"";
+                // first character-string only, its length is limited by the record data
+                offset = rdlength > 0 ? min<size_t>(rdata[0], rdlength - 1u) : 0;
+                result += '"';
+                result.append(raw + 1, offset);
+                result += '"';
                 break;
             default:
-                return rdata;
+                result.append(raw, rdlength);
+                break;
         }
-        return result;
+        return nullptr;
     }
 
 private:
-    string name;
+    // name with trailing dot, allocated in the arena of the packet
+    string_view name;
     uint16_t type = 0;
     uint16_t class_ = 0;
     uint32_t ttl = 0;
     uint16_t rdlength = 0;
-    string rdata;
+    const uint8_t* rdata = nullptr;
 
     size_t recordLength = 0;
+    // offset of TTL field from start of the packet
+    size_t ttlOffset = 0;
     const uint8_t* packet = nullptr;
+    const uint8_t* packetEnd = nullptr;
 };
 
 class DNSPacket {
@@ -595,64 +725,73 @@ public:
         this->question = question;
     }
 
-    DNSPacket(const uint8_t* buffer) {
-        this->header = DNSHeader(buffer);
-        size_t offset = 6 * sizeof(uint16_t);
-        this->question = DNSQuestion(buffer + offset);
-        offset += 2 * sizeof(uint16_t) + question.getNameDns().length();
-        for (int i = 0; i < header.getAncount(); i++) {
-            DNSRecord answer(buffer + offset, buffer);
-            answers.push_back(answer);
-            offset += answer.getRecordLength();
+    /**
+     * @brief Parses response packet, the packet is copied into the arena and all parsed data point into it.
+     * When no arena is given, packet creates its own arena shared by its copies.
+     * Question section may be empty (continuation messages of zone transfer).
+     */
+    DNSPacket(const uint8_t* buffer, const size_t length, pmr::memory_resource* arena = nullptr) :
+        ownedArena(arena == nullptr ? make_shared<Arena>(PACKET_ARENA_SIZE) : nullptr),
+        resource(arena == nullptr ? ownedArena.get() : arena),
+        raw(copyToArena(resource, buffer, length)),
+        rawLength(length),
+        question(resource),
+        answers(resource),
+        authorities(resource),
+        additionals(resource) {
+        WireReader reader(raw, rawLength);
+        const WireHeader* wire_header = reader.view<WireHeader>();
+        if (wire_header == nullptr) {
+            malformed = true;
+            return;
         }
-        for (int i = 0; i < header.getNscount(); i++) {
-            DNSRecord authority(buffer + offset, buffer);
-            authorities.push_back(authority);
-            offset += authority.getRecordLength();
+        header = DNSHeader(*wire_header);
+        if (header.getQdcount() > 0) {
+            question = DNSQuestion(reader, resource);
         }
-        for (int i = 0; i < header.getArcount(); i++) {
-            DNSRecord additional(buffer + offset, buffer);
-            additionals.push_back(additional);
-            offset += additional.getRecordLength();
+        // records are parsed until the first one that exceeds the packet
+        for (auto* section : {&answers, &authorities, &additionals}) {
+            const uint16_t count = section == &answers ? header.getAncount()
+                                 : section == &authorities ? header.getNscount() : header.getArcount();
+            section->reserve(count);
+            for (int i = 0; i < count && reader.isValid(); i++) {
+                section->emplace_back(reader, resource);
+                if (!reader.isValid()) {
+                    section->pop_back();
+                }
+            }
         }
+        malformed = !reader.isValid();
     }
 
     unique_ptr<uint8_t[]> getBytes() const {
-        unique_ptr<uint8_t[]> buffer(new uint8_t[getSize()]);
-        //header
-        const uint16_t id = htonse(header.getId());
-        memcpy(buffer.get(), &id, sizeof(uint16_t));
-        size_t offset = sizeof(uint16_t);
-        const uint16_t flags = htonse(header.getFlags());
-        memcpy(buffer.get() + offset, &flags, sizeof(uint16_t));
-        offset += sizeof(uint16_t);
-        const uint16_t qdcount = htonse(header.getQdcount());
-        memcpy(buffer.get() + offset, &qdcount, sizeof(uint16_t));
-        offset += sizeof(uint16_t);
-        const uint16_t ancount = htonse(header.getAncount());
-        memcpy(buffer.get() + offset, &ancount, sizeof(uint16_t));
-        offset += sizeof(uint16_t);
-        const uint16_t nscount = htonse(header.getNscount());
-        memcpy(buffer.get() + offset, &nscount, sizeof(uint16_t));
-        offset += sizeof(uint16_t);
-        const uint16_t arcount = htonse(header.getArcount());
-        memcpy(buffer.get() + offset, &arcount, sizeof(uint16_t));
-        offset += sizeof(uint16_t);
-
-        //question
-        memcpy(buffer.get() + offset, question.getNameDns().c_str(), question.getNameDns().length());
-        offset += question.getNameDns().length();
-        uint16_t qtype = htonse(question.getType());
-        memcpy(buffer.get() + offset, &qtype, sizeof(uint16_t));
-        offset += sizeof(uint16_t);
-        uint16_t qclass = htonse(question.getClass());
-        memcpy(buffer.get() + offset, &qclass, sizeof(uint16_t));
-
+        const string name = question.getNameDns();
+        const size_t size = sizeof(WireHeader) + name.length() + sizeof(WireQuestion);
+        unique_ptr<uint8_t[]> buffer(new uint8_t[size]);
+        WireWriter writer(buffer.get(), size);
+
+        WireHeader* wire_header = writer.view<WireHeader>();
+        wire_header->id = header.getId();
+        wire_header->flags = header.getFlags();
+        wire_header->qdcount = header.getQdcount();
+        wire_header->ancount = header.getAncount();
+        wire_header->nscount = header.getNscount();
+        wire_header->arcount = header.getArcount();
+
+        writer.writeBytes(name.data(), name.length());
+        WireQuestion* wire_question = writer.view<WireQuestion>();
+        wire_question->type = question.getType();
+        wire_question->class_ = question.getClass();
         return buffer;
     }
 
     size_t getSize() const {
-        return 8 * sizeof(uint16_t) + question.getNameDns().length();
+        return sizeof(WireHeader) + question.getNameDns().length() + sizeof(WireQuestion);
+    }
+
+    // packet ends inside of header or record, records after the malformed one are not parsed
+    bool isMalformed() const {
+        return malformed;
     }
 
     const DNSHeader& getHeader() const {
@@ -663,31 +802,55 @@ public:
         return question;
     }
 
-    const vector<DNSRecord>& getAnswers() const {
+    const pmr::vector<DNSRecord>& getAnswers() const {
         return answers;
     }
 
-    const vector<DNSRecord>& getAuthorities() const {
+    const pmr::vector<DNSRecord>& getAuthorities() const {
         return authorities;
     }
 
-    const vector<DNSRecord>& getAdditionals() const {
+    const pmr::vector<DNSRecord>& getAdditionals() const {
         return additionals;
     }
 
+    pmr::memory_resource* getResource() const {
+        return resource;
+    }
+
+    const uint8_t* getRaw() const {
+        return raw;
+    }
+
+    size_t getRawLength() const {
+        return rawLength;
+    }
+
 private:
+    // arena of parsed packet is sized for the packet and its formatted output
+    static constexpr size_t PACKET_ARENA_SIZE = 2 * BUFFER_SIZE;
+
+    static const uint8_t* copyToArena(pmr::memory_resource* arena, const uint8_t* buffer, const size_t length) {
+        uint8_t* data = static_cast<uint8_t*>(arena->allocate(length, alignof(uint32_t)));
+        memcpy(data, buffer, length);
+        return data;
+    }
+
+    shared_ptr<Arena> ownedArena;
+    pmr::memory_resource* resource = pmr::get_default_resource();
+    const uint8_t* raw = nullptr;
+    size_t rawLength = 0;
+
     DNSHeader header;
     DNSQuestion question;
-    vector<DNSRecord> answers;
-    vector<DNSRecord> authorities;
-    vector<DNSRecord> additionals;
+    pmr::vector<DNSRecord> answers;
+    pmr::vector<DNSRecord> authorities;
+    pmr::vector<DNSRecord> additionals;
+    bool malformed = false;
 };
 
-void dns_init(const string& host, uint16_t port);
-DNSPacket dns_send(const DNSPacket& packet);
+void dns_format_record(const DNSRecord& record, size_t longest_name, pmr::string& out);
+void dns_format(const DNSPacket& packet, pmr::string& out);
 void dns_print(const DNSPacket& packet);
-void dns_close();
-
-string dns_get_default_server();
 
 #endif // DNS_H
@@ -0,0 +1,550 @@
+/**
+ * @file forwarder.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of caching stub/forwarder daemon mode
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "forwarder.h"
+
+#include <cerrno>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "dns.h"
+#include "cache.h"
+#include "stats.h"
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <fcntl.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using namespace std;
+
+/**
+ * @brief Client waiting for response, responses carry ID, RD flag and question of client's query
+ */
+struct Client {
+    bool tcp = false;
+    uint64_t connection = 0;
+    sockaddr_storage address{};
+    socklen_t address_length = 0;
+    uint16_t id = 0;
+    bool recursion = false;
+    vector<uint8_t> question;
+};
+
+/**
+ * @brief TCP connection of client, messages are prefixed by two byte length.
+ * Socket is non-blocking, responses the client did not read yet wait in output until socket is writable
+ */
+struct Connection {
+    int fd = -1;
+    uint64_t id = 0;
+    vector<uint8_t> buffer;
+    vector<uint8_t> output;
+    // client closed connection, or failed or stopped reading, connection is removed by poll loop
+    bool closing = false;
+};
+
+static Resolver* upstream = nullptr;
+static unique_ptr<AnswerCache> cache;
+// clients of identical misses waiting for one upstream query
+static unordered_map<string, vector<Client>> waiting_clients;
+// cache keys of upstream queries by index of query
+static unordered_map<size_t, string> upstream_keys;
+// misses waiting for free slot in window of upstream queries
+static deque<pair<string, DNSQuestion>> backlog;
+static int udp_fd = -1;
+static int tcp_fd = -1;
+static vector<Connection> connections;
+static uint64_t next_connection = 1;
+
+/**
+ * @brief Parses listen address in form ADDR:PORT or [IPv6]:PORT
+ * @param listen listen address
+ * @param address output address
+ * @param port output port
+ * @return true if listen address is valid
+ */
+bool dns_forwarder_parse_listen(const string& listen, string& address, string& port) {
+    const size_t colon = listen.rfind(':');
+    if (colon == string::npos || colon == 0 || colon + 1 == listen.length()) {
+        return false;
+    }
+    address = listen.substr(0, colon);
+    port = listen.substr(colon + 1);
+    if (address.front() == '[' && address.back() == ']') {
+        address = address.substr(1, address.length() - 2);
+    } else if (address.find(':') != string::npos) {
+        return false; // IPv6 address must be in brackets
+    }
+    char* endptr;
+    const long number = strtol(port.c_str(), &endptr, 10);
+    return *endptr == '\0' && number >= 0 && number <= 65535;
+}
+
+/**
+ * @brief Computes length of question section of query, name is checked to be inside of the packet
+ * @param data query packet
+ * @param length length of query packet
+ * @return length of question (name, type, class) or 0 if question is malformed
+ */
+static size_t question_length(const uint8_t* data, const size_t length) {
+    WireReader reader(data, length, sizeof(WireHeader));
+    while (reader.isValid() && reader.getRemaining() > 0 && reader.getPosition()[0] != 0) {
+        if (is_compressed(reader.getPosition()[0]) || reader.getPosition()[0] > 63) {
+            return 0;
+        }
+        reader.skip(reader.getPosition()[0] + 1u);
+    }
+    reader.skip(1 + sizeof(WireQuestion));
+    const size_t size = reader.getOffset() - sizeof(WireHeader);
+    return reader.isValid() && size <= MAX_NAME_LENGTH + sizeof(WireQuestion) ? size : 0;
+}
+
+/**
+ * @brief Switches accepted socket to non-blocking mode, so one client cannot stall the poll loop
+ * @param fd socket descriptor
+ * @return true on success
+ */
+static bool set_nonblocking(const int fd) {
+#if defined(_WIN32) || defined(_WIN64)
+    u_long enable = 1;
+    return ioctlsocket(fd, FIONBIO, &enable) == 0;
+#else
+    const int flags = fcntl(fd, F_GETFL, 0);
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+#endif
+}
+
+/**
+ * @brief Sends as much of output of TCP connection as socket accepts without blocking, the rest waits for POLLOUT
+ * @param connection client connection
+ */
+static void flush_connection(Connection& connection) {
+    size_t sent = 0;
+    while (sent < connection.output.size()) {
+        const ssize_t result = send(connection.fd, reinterpret_cast<const char*>(connection.output.data() + sent),
+                                    connection.output.size() - sent, MSG_NOSIGNAL);
+        if (result <= 0) {
+            if (result == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                connection.closing = true;
+            }
+            break;
+        }
+        sent += static_cast<size_t>(result);
+    }
+    stats_count(Counter::BytesSent, sent);
+    connection.output.erase(connection.output.begin(), connection.output.begin() + static_cast<ptrdiff_t>(sent));
+}
+
+/**
+ * @brief Sends message to client over its transport, TCP message is queued to output of connection
+ * @param client receiving client
+ * @param message message in wire format
+ * @param length length of message
+ */
+static void send_to_client(const Client& client, const uint8_t* message, const size_t length) {
+    if (!client.tcp) {
+        (void)sendto(udp_fd, message, length, 0, reinterpret_cast<const sockaddr*>(&client.address), client.address_length);
+        stats_count(Counter::BytesSent, length);
+        return;
+    }
+
+    for (auto& connection : connections) {
+        if (connection.id != client.connection) {
+            continue;
+        }
+        if (connection.closing) {
+            return;
+        }
+        const size_t start = connection.output.size();
+        connection.output.resize(start + sizeof(uint16_t) + length);
+        WireWriter writer(connection.output.data() + start, sizeof(uint16_t) + length);
+        writer.write(static_cast<uint16_t>(length));
+        writer.writeBytes(message, length);
+        if (connection.output.size() > MAX_TCP_OUTPUT) {
+            connection.closing = true;
+            return;
+        }
+        flush_connection(connection);
+        return;
+    }
+}
+
+/**
+ * @brief Sends response to client with ID, RD flag and question of client's query,
+ * UDP responses longer than 512 bytes are truncated to header and question with TC flag
+ * @param client receiving client
+ * @param response response in wire format, modified
+ */
+static void reply(const Client& client, vector<uint8_t>& response) {
+    auto* header = reinterpret_cast<WireHeader*>(response.data());
+    header->id = client.id;
+    header->flags = static_cast<uint16_t>((header->flags & ~DNSHeader::FLAGS::RD) | (client.recursion ? DNSHeader::FLAGS::RD : 0));
+    // question with letter case of client (names are equal case insensitive)
+    if (response.size() >= sizeof(WireHeader) + client.question.size() &&
+        question_length(response.data(), response.size()) == client.question.size()) {
+        copy(client.question.begin(), client.question.end(), response.begin() + sizeof(WireHeader));
+    }
+
+    if (!client.tcp && response.size() > MAX_UDP_RESPONSE) {
+        response.resize(sizeof(WireHeader) + client.question.size());
+        header = reinterpret_cast<WireHeader*>(response.data());
+        header->flags = header->flags | DNSHeader::FLAGS::TC;
+        header->ancount = 0;
+        header->nscount = 0;
+        header->arcount = 0;
+    }
+    send_to_client(client, response.data(), response.size());
+}
+
+/**
+ * @brief Sends response without records with response code to client
+ * @param client receiving client
+ * @param rcode response code
+ */
+static void reply_error(const Client& client, const uint16_t rcode) {
+    vector<uint8_t> response(sizeof(WireHeader) + client.question.size());
+    WireWriter writer(response.data(), response.size());
+    WireHeader* header = writer.view<WireHeader>();
+    header->id = client.id;
+    header->flags = DNSHeader::FLAGS::QR_RESPONSE | DNSHeader::FLAGS::RA | (client.recursion ? DNSHeader::FLAGS::RD : 0) | rcode;
+    header->qdcount = client.question.empty() ? 0 : 1;
+    writer.writeBytes(client.question.data(), client.question.size());
+    send_to_client(client, response.data(), response.size());
+}
+
+static void handle_upstream(size_t index, const DNSQuestion& question, const DNSPacket* response);
+
+/**
+ * @brief Submits upstream queries of misses waiting for free slot in window,
+ * clients of query that cannot be sent are answered by server failure at once
+ * @return status of the last failed submit, Ok when all queries were sent
+ */
+static ResolverStatus submit_backlog() {
+    ResolverStatus status = ResolverStatus::Ok;
+    while (!backlog.empty() && !upstream->windowFull()) {
+        size_t index;
+        const ResolverStatus submitted = upstream->submit(backlog.front().second, true, index);
+        upstream_keys[index] = move(backlog.front().first);
+        if (submitted != ResolverStatus::Ok) {
+            handle_upstream(index, backlog.front().second, nullptr);
+            status = submitted;
+        }
+        backlog.pop_front();
+    }
+    return status;
+}
+
+/**
+ * @brief Answers query from cache, misses are forwarded upstream, identical misses share one upstream query
+ * @param data query packet
+ * @param length length of query packet
+ * @param client client that sent query (without ID and question)
+ * @param arena arena for parsed question
+ */
+static void handle_query(const uint8_t* data, const size_t length, Client client, Arena& arena) {
+    if (length < sizeof(WireHeader)) {
+        return;
+    }
+    const DNSHeader header(data);
+    client.id = header.getId();
+    client.recursion = header.getFlags() & DNSHeader::FLAGS::RD;
+    if (header.getFlags() & DNSHeader::FLAGS::QR_RESPONSE) {
+        return;
+    }
+
+    const size_t question_size = header.getQdcount() == 1 ? question_length(data, length) : 0;
+    if (question_size == 0) {
+        reply_error(client, 1); // format error
+        return;
+    }
+    client.question.assign(data + sizeof(WireHeader), data + sizeof(WireHeader) + question_size);
+    // only standard queries are supported (opcode 0)
+    if ((header.getFlags() & 0x7800) != 0) {
+        reply_error(client, 4); // not implemented
+        return;
+    }
+
+    arena.reset();
+    WireReader reader(data, length, sizeof(WireHeader));
+    const DNSQuestion parsed(reader, &arena);
+    const string key = AnswerCache::key(parsed);
+
+    vector<uint8_t> response;
+    bool prefetch;
+    if (cache->lookup(key, response, prefetch)) {
+        stats_count(Counter::CacheHits);
+        reply(client, response);
+        // popular entry about to expire is refreshed by upstream query without waiting clients
+        if (prefetch && waiting_clients.find(key) == waiting_clients.end() && backlog.size() < MAX_FORWARD_BACKLOG) {
+            stats_count(Counter::CachePrefetches);
+            waiting_clients[key];
+            backlog.emplace_back(key, DNSQuestion(string(parsed.getName()), parsed.getType(), parsed.getClass()));
+        }
+        return;
+    }
+    stats_count(Counter::CacheMisses);
+
+    auto waiting = waiting_clients.find(key);
+    if (waiting != waiting_clients.end()) {
+        if (waiting->second.size() >= MAX_WAITING_CLIENTS) {
+            stats_count(Counter::ForwardRejects);
+            reply_error(client, 5); // refused
+            return;
+        }
+        waiting->second.push_back(move(client));
+        return;
+    }
+    // upstream does not keep up, misses are not queued without bound
+    if (backlog.size() >= MAX_FORWARD_BACKLOG) {
+        stats_count(Counter::ForwardRejects);
+        reply_error(client, 2); // server failure
+        return;
+    }
+    waiting_clients[key].push_back(move(client));
+    backlog.emplace_back(key, DNSQuestion(string(parsed.getName()), parsed.getType(), parsed.getClass()));
+}
+
+/**
+ * @brief Caches upstream response and sends it to all clients waiting for it
+ * @param index index of upstream query
+ * @param response parsed response, nullptr when upstream did not respond
+ */
+static void handle_upstream(const size_t index, const DNSQuestion&, const DNSPacket* response) {
+    const auto key = upstream_keys.find(index);
+    if (key == upstream_keys.end()) {
+        return;
+    }
+    const auto waiting = waiting_clients.find(key->second);
+    if (response != nullptr) {
+        cache->insert(key->second, *response);
+    } else {
+        cache->prefetchFailed(key->second);
+    }
+
+    if (waiting != waiting_clients.end()) {
+        for (const auto& client : waiting->second) {
+            if (response == nullptr) {
+                reply_error(client, 2); // server failure
+                continue;
+            }
+            vector<uint8_t> message(response->getRaw(), response->getRaw() + response->getRawLength());
+            reply(client, message);
+        }
+        waiting_clients.erase(waiting);
+    }
+    upstream_keys.erase(key);
+}
+
+/**
+ * @brief Creates socket bound to listen address
+ * @param address listen address
+ * @param port listen port
+ * @param type SOCK_DGRAM or SOCK_STREAM
+ * @return socket descriptor
+ */
+static int open_listen_socket(const string& address, const string& port, const int type) {
+    addrinfo hints{}, *result;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = type;
+    hints.ai_flags = AI_PASSIVE;
+
+    int status;
+    if ((status = getaddrinfo(address.c_str(), port.c_str(), &hints, &result)) != 0) {
+        error_exit(ErrorCodes::SocketError, "Listen address - " + string(gai_strerror(status)));
+    }
+
+    int fd = -1;
+    for (addrinfo* ai = result; ai != nullptr; ai = ai->ai_next) {
+        if ((fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) == -1) {
+            continue;
+        }
+        const int enable = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&enable), sizeof(enable));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && (type != SOCK_STREAM || listen(fd, SOMAXCONN) == 0)) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+
+    if (fd == -1) {
+        error_exit(ErrorCodes::SocketError, "Cannot listen on " + address + ":" + port + (type == SOCK_STREAM ? " (TCP)" : " (UDP)"));
+    }
+    return fd;
+}
+
+/**
+ * @brief Reads data of TCP connection and handles all complete queries
+ * @param connection client connection
+ * @param arena arena for parsed questions
+ * @return false when connection was closed
+ */
+static bool read_connection(Connection& connection, Arena& arena) {
+    uint8_t buffer[BUFFER_SIZE];
+    const ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+    if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return true;
+    }
+    if (received <= 0) {
+        return false;
+    }
+    stats_count(Counter::BytesReceived, static_cast<uint64_t>(received));
+    connection.buffer.insert(connection.buffer.end(), buffer, buffer + received);
+
+    size_t offset = 0;
+    while (connection.buffer.size() - offset >= 2) {
+        const size_t length = *reinterpret_cast<const BigEndian<uint16_t>*>(connection.buffer.data() + offset);
+        if (connection.buffer.size() - offset - 2 < length) {
+            break;
+        }
+        Client client;
+        client.tcp = true;
+        client.connection = connection.id;
+        handle_query(connection.buffer.data() + offset + 2, length, move(client), arena);
+        offset += 2 + length;
+    }
+    connection.buffer.erase(connection.buffer.begin(), connection.buffer.begin() + static_cast<ptrdiff_t>(offset));
+    return true;
+}
+
+/**
+ * @brief Reports change of upstream state, failures are reported once until upstream works again
+ * @param status status of the last upstream operation
+ * @param reported status reported before, updated
+ */
+static void report_upstream(const ResolverStatus status, ResolverStatus& reported) {
+    if (status != ResolverStatus::Ok && reported == ResolverStatus::Ok) {
+        warning_print(string("Upstream server - ") + resolver_status_string(status) + ", clients are answered by server failure");
+    }
+    reported = status;
+}
+
+/**
+ * @brief Runs caching forwarder: answers UDP and TCP queries from cache and forwards misses to server
+ * of upstream resolver, runs until program is interrupted. Failing upstream does not stop forwarder,
+ * clients of queries that cannot be sent or are given up are answered by server failure
+ * @param resolver open upstream resolver
+ * @param address listen address
+ * @param port listen port
+ * @param window maximum number of upstream queries in flight
+ * @param prefetch_percent entries hit within this last percent of their TTL are refreshed (0 disables prefetch)
+ * @param prefetch_rate minimum hits per minute of refreshed entries
+ * @param cache_size memory budget of cache in bytes
+ * @return status of upstream resolver when its window cannot be opened
+ */
+ResolverStatus dns_forwarder(Resolver& resolver, const string& address, const string& port, const size_t window,
+                             const unsigned prefetch_percent, const unsigned prefetch_rate, const size_t cache_size) {
+    upstream = &resolver;
+    cache = make_unique<AnswerCache>(cache_size, prefetch_percent, prefetch_rate);
+    udp_fd = open_listen_socket(address, port, SOCK_DGRAM);
+    tcp_fd = open_listen_socket(address, port, SOCK_STREAM);
+    const ResolverStatus status = resolver.openWindow(window);
+    if (status != ResolverStatus::Ok) {
+        close(udp_fd);
+        close(tcp_fd);
+        return status;
+    }
+    // the last reported state of upstream
+    ResolverStatus upstream_status = ResolverStatus::Ok;
+
+    Arena upstream_arena;
+    Arena query_arena(BUFFER_SIZE);
+    uint8_t buffer[BUFFER_SIZE];
+    vector<pollfd> fds;
+
+    while (true) {
+        fds.assign(3 + connections.size(), pollfd{});
+        fds[0].fd = udp_fd;
+        fds[1].fd = tcp_fd;
+        fds[2].fd = resolver.getSocket();
+        for (auto& fd : fds) {
+            fd.events = POLLIN;
+        }
+        for (size_t i = 0; i < connections.size(); i++) {
+            fds[3 + i].fd = connections[i].fd;
+            if (!connections[i].output.empty()) {
+                fds[3 + i].events |= POLLOUT;
+            }
+        }
+
+        StageTimer wait_timer(Stage::Wait);
+        const int ready = poll(fds.data(), static_cast<nfds_t>(fds.size()), resolver.windowTimeout());
+        wait_timer.stop();
+        if (ready < 0) {
+            continue;
+        }
+
+        // Queries over UDP
+        if (fds[0].revents & POLLIN) {
+            Client client;
+            client.address_length = sizeof(client.address);
+            ssize_t length;
+            while ((length = recvfrom(udp_fd, buffer, sizeof(buffer), MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&client.address), &client.address_length)) >= 0) {
+                stats_count(Counter::BytesReceived, static_cast<uint64_t>(length));
+                handle_query(buffer, static_cast<size_t>(length), client, query_arena);
+                client.address_length = sizeof(client.address);
+            }
+        }
+
+        // New TCP connections
+        if (fds[1].revents & POLLIN) {
+            const int fd = accept(tcp_fd, nullptr, nullptr);
+            if (fd != -1 && (connections.size() >= MAX_TCP_CLIENTS || !set_nonblocking(fd))) {
+                close(fd);
+            } else if (fd != -1) {
+                connections.push_back({fd, next_connection++, {}, {}, false});
+            }
+        }
+
+        // Upstream responses and retransmissions, pending error of socket (e.g. refused port) is taken by receive,
+        // queries of failing upstream are given up by expire and their clients get server failure
+        // (state of upstream changes back to Ok only by successful receive)
+        ResolverStatus upstream_result = upstream_status;
+        if (fds[2].revents & (POLLIN | POLLERR)) {
+            upstream_result = resolver.receive(handle_upstream, &upstream_arena);
+        }
+        const ResolverStatus expired = resolver.expire(handle_upstream);
+        if (expired != ResolverStatus::Ok) {
+            upstream_result = expired;
+        }
+
+        // Queries and pending responses over TCP
+        for (size_t i = 3; i < fds.size(); i++) {
+            Connection& connection = connections[i - 3];
+            if (connection.closing) {
+                continue;
+            }
+            if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) && !read_connection(connection, query_arena)) {
+                connection.closing = true;
+            }
+            if ((fds[i].revents & POLLOUT) && !connection.closing) {
+                flush_connection(connection);
+            }
+        }
+
+        const ResolverStatus submitted = submit_backlog();
+        report_upstream(submitted != ResolverStatus::Ok ? submitted : upstream_result, upstream_status);
+
+        // Closed connections are removed after all their responses were handled
+        for (auto it = connections.begin(); it != connections.end();) {
+            if (it->closing) {
+                close(it->fd);
+                it = connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
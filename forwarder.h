@@ -0,0 +1,31 @@
+/**
+ * @file forwarder.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of caching stub/forwarder daemon mode
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef FORWARDER_H
+#define FORWARDER_H
+
+#include <string>
+
+#include "cache.h"
+#include "resolver.h"
+
+// maximum size of response sent over UDP to client without EDNS (RFC 1035 section 4.2.1)
+constexpr size_t MAX_UDP_RESPONSE = 512;
+constexpr size_t MAX_TCP_CLIENTS = 128;
+// responses waiting until TCP client reads them, connection of client that does not read is closed above it
+constexpr size_t MAX_TCP_OUTPUT = 256 * 1024;
+// misses waiting for free slot in window of upstream queries, new misses above it are answered by server failure
+constexpr size_t MAX_FORWARD_BACKLOG = 4096;
+// clients waiting for one upstream query, further clients with the same question are refused
+constexpr size_t MAX_WAITING_CLIENTS = 256;
+
+bool dns_forwarder_parse_listen(const std::string& listen, std::string& address, std::string& port);
+ResolverStatus dns_forwarder(Resolver& resolver, const std::string& address, const std::string& port, size_t window,
+                             unsigned prefetch_percent, unsigned prefetch_rate, size_t cache_size);
+
+#endif // FORWARDER_H
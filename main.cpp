@@ -11,44 +11,216 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <map>
+#include <deque>
+#include <optional>
+#include <csignal>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
 
 #include "error.h"
 #include "dns.h"
+#include "resolver.h"
+#include "resolvconf.h"
+#include "sweep.h"
+#include "stats.h"
+#include "forwarder.h"
+#include "transfer.h"
+#include "compare.h"
+#include "nxfilter.h"
+#include "results.h"
+#include "pipeline.h"
 
 using namespace std;
 
 // variables for dns resolver
 vector<string> addresses;
 string server;
-RR_TYPE type = RR_TYPE::A;
+// servers of comparison mode, option '-s' can be repeated only there
+vector<string> servers;
+// file with queries of comparison mode, each line is name optionally followed by TYPE[,TYPE...]
+string queries_file;
+// types requested for each address in order of output, A when no type option is given
+vector<RR_TYPE> types;
+// serial of zone copy for IXFR
+uint32_t transfer_serial = 0;
 bool recursion = false;
 long port = 53;
+long window = DEFAULT_WINDOW;
+// system resolver configuration (resolv.conf), not read when server is given by -s
+ResolverConfig config;
+string listen_address;
+string listen_port;
+unsigned long prefetch_percent = CACHE_PREFETCH_PERCENT;
+unsigned long prefetch_rate = CACHE_PREFETCH_RATE;
+unsigned long cache_size = CACHE_MEMORY_BUDGET;
+// rate limit and socket buffers of each upstream server in bulk, forwarder and comparison mode
+PacingConfig pacing;
+// session log of queries and responses of all resolvers (--record)
+SessionRecorder recorder;
+// recorded session served on loopback instead of server (--replay)
+string replay_file;
+double replay_speed = 1;
+ReplayServer replay_server;
+vector<CompareQuery> replay_queries;
+// known nonexistent names of bulk runs, loaded from and saved to file (--nx-filter)
+string nx_filter_file;
+double nx_false_positive_rate = NXFILTER_FALSE_POSITIVE_RATE;
+unique_ptr<NegativeFilter> nx_filter;
+// filter is checked by I/O stage and filled by parse stage of pipeline (--pipeline)
+mutex nx_filter_mutex;
+// set by SIGINT, resolver of addresses stops on it and program returns normally,
+// modes which do not check it exit from signal handler
+volatile sig_atomic_t interrupted = 0;
+volatile sig_atomic_t interrupt_checked = 0;
+// answers of bulk run kept in columnar store and summarized after run (--summary), columns spill to directory (--spill)
+string spill_directory;
+unique_ptr<ResultStore> results;
 
+bool got_ipv6 = false;
+bool got_reverse = false;
 bool got_type = false;
 bool got_server = false;
 bool got_port = false;
 bool got_recursion = false;
+bool got_window = false;
+bool got_stats = false;
+bool got_trace = false;
+bool got_listen = false;
+bool got_prefetch = false;
+bool got_cache_size = false;
+bool got_compare = false;
+bool got_qps = false;
+bool got_sockbuf = false;
+bool got_max_inflight = false;
+bool got_timestamps = false;
+bool got_io_uring = false;
+bool got_queries = false;
+bool got_record = false;
+bool got_replay = false;
+bool got_replay_speed = false;
+bool got_nx_filter = false;
+bool got_nx_fp = false;
+bool got_summary = false;
+bool got_spill = false;
+bool got_pipeline = false;
+bool got_unordered = false;
 
 /**
  * @brief Prints help message
  */
 void print_help() {
-    cout << "Usage: dns [-r] [-6 | -x | -t TYPE] [-s SERVER] [-p PORT] ADDRESS [ADDRESS...]" << endl;
+    cout << "Usage: dns [-r] [-6] [-x] [-t TYPE[,TYPE...]] [-s SERVER] [-p PORT] [-w WINDOW] [--qps RATE] [--max-inflight N] [--sockbuf BYTES] [--timestamps] [--io-uring] [--record FILE] [--replay FILE [--replay-speed FACTOR]] [--nx-filter FILE [--nx-fp RATE]] [--summary [--spill DIR]] [--pipeline [--unordered]] [--stats] [--trace FILE] ADDRESS [ADDRESS...]" << endl;
+    cout << "       dns [-s SERVER] [-p PORT] [-w WINDOW] [--qps RATE] [--max-inflight N] [--sockbuf BYTES] [--timestamps] [--io-uring] [--record FILE] [--replay FILE [--replay-speed FACTOR]] [--stats] [--trace FILE] --listen ADDR:PORT [--prefetch PERCENT[,RATE]] [--cache-size MBYTES]" << endl;
+    cout << "       dns --compare [-r] [-6] [-x] [-t TYPE[,TYPE...]] [-s SERVER...] [-p PORT] [-w WINDOW] [--qps RATE] [--max-inflight N] [--sockbuf BYTES] [--timestamps] [--io-uring] [--record FILE] [--trace FILE] [--queries FILE] [ADDRESS...]" << endl;
+    cout << "       dns --replay FILE [--replay-speed FACTOR] [-w WINDOW] [--qps RATE] [--max-inflight N] [--stats] [--trace FILE]" << endl;
     cout << "       dns --help" << endl;
     cout << "       Send DNS requests for all ADDRESS (IPv4) values to DNS server and print responses" << endl;
     cout << "Options:" << endl;
     cout << "  -r          recursion desired, otherwise without recursion" << endl;
     cout << "  -6          request type AAAA (IPv6) instead of default type A (IPv4)" << endl;
     cout << "  -x          request type PTR (domain) instead of default type A (IPv4)" << endl;
-    cout << "  -t TYPE     request type TYPE instead of default type A" << endl;
+    cout << "  -t TYPE[,TYPE...]  request types TYPE instead of default type A" << endl;
     cout << "              TYPE can be one of: A, NS, CNAME, SOA, PTR, MX, TXT, AAAA, ANY" << endl;
+    cout << "              or zone transfer AXFR or IXFR=SERIAL over TCP for single ADDRESS (zone), records are printed as they arrive" << endl;
+    cout << "              options -6, -x and -t can be combined, queries of all types of address are sent together" << endl;
+    cout << "              and responses are printed grouped by address in order of types" << endl;
     cout << "  -s SERVER   DNS server host name or IP address, where to send request" << endl;
     cout << "              default server is obtained from system configuration" << endl;
     cout << "  -p PORT     DNS server port number, default 53" << endl;
+    cout << "  -w WINDOW   maximum number of requests in flight for multiple addresses, default " << DEFAULT_WINDOW << endl;
+    cout << "  --qps RATE  send at most RATE queries per second to each server (retransmissions included), default unlimited" << endl;
+    cout << "              in-flight limit and rate are halved when loss or REFUSED responses rise and recover with clean responses" << endl;
+    cout << "  --max-inflight N  send at most N queries in flight to each server, default WINDOW" << endl;
+    cout << "              (WINDOW is number of queries tracked at once, N caps how many of them are sent and not answered)" << endl;
+    cout << "  --sockbuf BYTES  size of socket receive and send buffers, default system size" << endl;
+    cout << "  --timestamps  measure round trip time from send syscall to kernel receive timestamp of response" << endl;
+    cout << "              (reported by --stats and --compare, used for retransmission timeout)" << endl;
+    cout << "  --io-uring  send and receive queries of multiple addresses through io_uring (Linux 6.0)," << endl;
+    cout << "              socket is used when it is not available" << endl;
+    cout << "  --record FILE  write every query with its response and latency to FILE (binary session log)" << endl;
+    cout << "  --replay FILE  answer queries by responses of session log FILE from server on loopback after recorded latency," << endl;
+    cout << "              without ADDRESS all recorded queries are sent and their latency percentiles are reported" << endl;
+    cout << "  --replay-speed FACTOR  multiply recorded latencies by FACTOR (default 1, 0 answers at once)" << endl;
+    cout << "  --nx-filter FILE  names answered by NXDOMAIN are kept in FILE for their negative TTL and are not queried" << endl;
+    cout << "              again by bulk runs (multiple addresses or address range)" << endl;
+    cout << "  --nx-fp RATE  false positive rate of the first tier of filter, checked by exact tier (default " << NXFILTER_FALSE_POSITIVE_RATE << ")" << endl;
+    cout << "  --summary   keep answer records of multiple addresses in compact store and print the most common record" << endl;
+    cout << "              data, TTL histogram and CNAME chains after all responses" << endl;
+    cout << "  --spill DIR  move store of '--summary' to files of DIR when it exceeds " << (RESULTS_SPILL_THRESHOLD >> 20) << " MiB of memory" << endl;
+    cout << "  --pipeline  receive, parse and print responses of multiple addresses in three threads connected by queues" << endl;
+    cout << "              (depth of queues is reported by --stats)" << endl;
+    cout << "  --unordered  with '--pipeline' print responses as they complete instead of in order of addresses" << endl;
     cout << "  ADDRESS     IPv4/IPv6 address or domain depending on request type" << endl;
+    cout << "              with '-x' also address range in CIDR notation (e.g. 10.0.0.0/16), at most " << MAX_SWEEP_ADDRESSES << " addresses" << endl;
+    cout << "  --stats     print time spent in each stage (percentiles) and transfer counters to stderr on exit" << endl;
+    cout << "  --trace FILE  write timeline of all queries (encode, send, retransmit, wait, parse, print)" << endl;
+    cout << "              to FILE in Chrome trace-event JSON format (chrome://tracing, Perfetto)" << endl;
+    cout << "  --listen ADDR:PORT  run as caching forwarder, answer UDP and TCP queries on ADDR:PORT ([IPv6]:PORT)" << endl;
+    cout << "              from cache, forward misses to SERVER (identical misses share one query)" << endl;
+    cout << "  --prefetch PERCENT[,RATE]  refresh cached answers hit within last PERCENT of TTL with at least" << endl;
+    cout << "              RATE hits per minute (default " << CACHE_PREFETCH_PERCENT << "," << CACHE_PREFETCH_RATE << ", PERCENT 0 disables prefetch)" << endl;
+    cout << "  --cache-size MBYTES  memory of cached answers of forwarder, least recently used answers are evicted" << endl;
+    cout << "              above it (default " << (CACHE_MEMORY_BUDGET >> 20) << ")" << endl;
+    cout << "  --compare   send the same queries to every SERVER ('-s' can be repeated, default all system servers)" << endl;
+    cout << "              and report latency percentiles, timeout rate, response codes and disagreeing answers of each server" << endl;
+    cout << "  --queries FILE  queries of comparison, each line is name optionally followed by TYPE[,TYPE...]" << endl;
+    cout << "              (types of options '-6', '-x' and '-t' otherwise), lines starting with '#' are ignored" << endl;
     cout << "  --help      print this help and exit program" << endl;
 }
 
+/**
+ * @brief Parses name of query type
+ * @param type_arg upper case name of type
+ * @return type of query
+ */
+RR_TYPE parse_type(const string& type_arg) {
+    if (type_arg == "A") {
+        return RR_TYPE::A;
+    } else if (type_arg == "NS") {
+        return RR_TYPE::NS;
+    } else if (type_arg == "CNAME") {
+        return RR_TYPE::CNAME;
+    } else if (type_arg == "SOA") {
+        return RR_TYPE::SOA;
+    } else if (type_arg == "PTR") {
+        return RR_TYPE::PTR;
+    } else if (type_arg == "MX") {
+        return RR_TYPE::MX;
+    } else if (type_arg == "TXT") {
+        return RR_TYPE::TXT;
+    } else if (type_arg == "AAAA") {
+        return RR_TYPE::AAAA;
+    } else if (type_arg == "ANY") {
+        return RR_TYPE::ANY;
+    } else if (type_arg == "AXFR") {
+        return RR_TYPE::AXFR;
+    } else if (type_arg.rfind("IXFR=", 0) == 0) {
+        char *endptr;
+        const unsigned long serial = strtoul(type_arg.c_str() + 5, &endptr, 10);
+        if (*endptr != '\0' || type_arg.length() == 5 || serial > UINT32_MAX) {
+            error_exit(ErrorCodes::ArgumentError, "Invalid IXFR serial, use IXFR=SERIAL with serial in range (0 - " + to_string(UINT32_MAX) + ")");
+        }
+        transfer_serial = static_cast<uint32_t>(serial);
+        return RR_TYPE::IXFR;
+    }
+    error_exit(ErrorCodes::ArgumentError, "Invalid type, TYPE value must be one of: A, NS, CNAME, SOA, PTR, MX, TXT, AAAA, ANY, AXFR, IXFR=SERIAL");
+    return RR_TYPE::A;
+}
+
+/**
+ * @brief Adds type to requested types, repeated type is requested once
+ * @param type type of query
+ */
+void add_type(const RR_TYPE type) {
+    if (find(types.begin(), types.end(), type) == types.end()) {
+        types.push_back(type);
+    }
+}
+
 /**
  * @brief Parse command line arguments
  * @param argc argument count
@@ -64,10 +236,7 @@ void parse_args(const int argc, const char *argv[]) {
 
     for (int i = 1; i < argc; i++) {
         if (string(argv[i]) == "-s" && i < argc - 1) {
-            if (got_server) {
-                error_exit(ErrorCodes::ArgumentError, "Option '-s' cannot be used multiple times");
-            }
-            server = argv[++i];
+            servers.emplace_back(argv[++i]);
             got_server = true;
         } else if (string(argv[i]) == "-p" && i < argc - 1) {
             if (got_port) {
@@ -80,6 +249,180 @@ void parse_args(const int argc, const char *argv[]) {
                 error_exit(ErrorCodes::ArgumentError, "Invalid port, port must be integer in range (0 - 65535)");
             }
             got_port = true;
+        } else if (string(argv[i]) == "-w" && i < argc - 1) {
+            if (got_window) {
+                error_exit(ErrorCodes::ArgumentError, "Option '-w' cannot be used multiple times");
+            }
+            char *endptr;
+            window = strtol(argv[++i], &endptr, 10);
+
+            if (*endptr != '\0' || window < 1 || window > static_cast<long>(MAX_WINDOW)) {
+                error_exit(ErrorCodes::ArgumentError, "Invalid window, window must be integer in range (1 - " + to_string(MAX_WINDOW) + ")");
+            }
+            got_window = true;
+        } else if (string(argv[i]) == "--qps" && i < argc - 1) {
+            if (got_qps) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--qps' cannot be used multiple times");
+            }
+            char *endptr;
+            pacing.qps = strtod(argv[++i], &endptr);
+            if (*endptr != '\0' || !(pacing.qps > 0) || pacing.qps > 1e7) {
+                error_exit(ErrorCodes::ArgumentError, "Invalid rate, rate must be number of queries per second in range (0 - 10000000)");
+            }
+            got_qps = true;
+        } else if (string(argv[i]) == "--max-inflight" && i < argc - 1) {
+            if (got_max_inflight) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--max-inflight' cannot be used multiple times");
+            }
+            char *endptr;
+            const long limit = strtol(argv[++i], &endptr, 10);
+            if (*endptr != '\0' || limit < 1 || limit > static_cast<long>(MAX_WINDOW)) {
+                error_exit(ErrorCodes::ArgumentError, "Invalid in-flight limit, limit must be integer in range (1 - " + to_string(MAX_WINDOW) + ")");
+            }
+            pacing.max_in_flight = static_cast<size_t>(limit);
+            got_max_inflight = true;
+        } else if (string(argv[i]) == "--sockbuf" && i < argc - 1) {
+            if (got_sockbuf) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--sockbuf' cannot be used multiple times");
+            }
+            char *endptr;
+            const long size = strtol(argv[++i], &endptr, 10);
+            if (*endptr != '\0' || size < 1024 || size > (1l << 30)) {
+                error_exit(ErrorCodes::ArgumentError, "Invalid socket buffer, size must be integer in range (1024 - " + to_string(1l << 30) + ")");
+            }
+            pacing.socket_buffer = static_cast<int>(size);
+            got_sockbuf = true;
+        } else if (string(argv[i]) == "--timestamps") {
+            if (got_timestamps) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--timestamps' cannot be used multiple times");
+            }
+            got_timestamps = true;
+        } else if (string(argv[i]) == "--io-uring") {
+            if (got_io_uring) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--io-uring' cannot be used multiple times");
+            }
+            got_io_uring = true;
+        } else if (string(argv[i]) == "--record" && i < argc - 1) {
+            if (got_record) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--record' cannot be used multiple times");
+            }
+            string error;
+            if (!recorder.open(argv[++i], error)) {
+                error_exit(ErrorCodes::ArgumentError, error);
+            }
+            got_record = true;
+        } else if (string(argv[i]) == "--replay" && i < argc - 1) {
+            if (got_replay) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--replay' cannot be used multiple times");
+            }
+            replay_file = argv[++i];
+            got_replay = true;
+        } else if (string(argv[i]) == "--replay-speed" && i < argc - 1) {
+            if (got_replay_speed) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--replay-speed' cannot be used multiple times");
+            }
+            char *endptr;
+            replay_speed = strtod(argv[++i], &endptr);
+            if (*endptr != '\0' || !(replay_speed >= 0 && replay_speed <= 1000)) {
+                error_exit(ErrorCodes::ArgumentError, "Invalid replay speed, use factor of recorded latency (0 - 1000)");
+            }
+            got_replay_speed = true;
+        } else if (string(argv[i]) == "--nx-filter" && i < argc - 1) {
+            if (got_nx_filter) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--nx-filter' cannot be used multiple times");
+            }
+            nx_filter_file = argv[++i];
+            got_nx_filter = true;
+        } else if (string(argv[i]) == "--nx-fp" && i < argc - 1) {
+            if (got_nx_fp) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--nx-fp' cannot be used multiple times");
+            }
+            char *endptr;
+            nx_false_positive_rate = strtod(argv[++i], &endptr);
+            if (*endptr != '\0' || !(nx_false_positive_rate >= 1e-9 && nx_false_positive_rate <= 0.5)) {
+                error_exit(ErrorCodes::ArgumentError, "Invalid false positive rate, use number between 0.000000001 and 0.5");
+            }
+            got_nx_fp = true;
+        } else if (string(argv[i]) == "--summary") {
+            if (got_summary) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--summary' cannot be used multiple times");
+            }
+            got_summary = true;
+        } else if (string(argv[i]) == "--spill" && i < argc - 1) {
+            if (got_spill) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--spill' cannot be used multiple times");
+            }
+            spill_directory = argv[++i];
+            got_spill = true;
+        } else if (string(argv[i]) == "--pipeline") {
+            if (got_pipeline) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--pipeline' cannot be used multiple times");
+            }
+            got_pipeline = true;
+        } else if (string(argv[i]) == "--unordered") {
+            if (got_unordered) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--unordered' cannot be used multiple times");
+            }
+            got_unordered = true;
+        } else if (string(argv[i]) == "--stats") {
+            if (got_stats) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--stats' cannot be used multiple times");
+            }
+            stats_enable();
+            atexit(stats_report);
+            got_stats = true;
+        } else if (string(argv[i]) == "--trace" && i < argc - 1) {
+            if (got_trace) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--trace' cannot be used multiple times");
+            }
+            if (!trace_enable(argv[++i])) {
+                error_exit(ErrorCodes::ArgumentError, "Trace file '" + string(argv[i]) + "' cannot be created");
+            }
+            atexit(trace_flush);
+            got_trace = true;
+        } else if (string(argv[i]) == "--listen" && i < argc - 1) {
+            if (got_listen) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--listen' cannot be used multiple times");
+            }
+            if (!dns_forwarder_parse_listen(argv[++i], listen_address, listen_port)) {
+                error_exit(ErrorCodes::ArgumentError, "Invalid listen address '" + string(argv[i]) + "', use ADDR:PORT or [IPv6]:PORT");
+            }
+            got_listen = true;
+        } else if (string(argv[i]) == "--compare") {
+            if (got_compare) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--compare' cannot be used multiple times");
+            }
+            got_compare = true;
+        } else if (string(argv[i]) == "--queries" && i < argc - 1) {
+            if (got_queries) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--queries' cannot be used multiple times");
+            }
+            queries_file = argv[++i];
+            got_queries = true;
+        } else if (string(argv[i]) == "--prefetch" && i < argc - 1) {
+            if (got_prefetch) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--prefetch' cannot be used multiple times");
+            }
+            char *endptr;
+            prefetch_percent = strtoul(argv[++i], &endptr, 10);
+            if (*endptr == ',') {
+                prefetch_rate = strtoul(endptr + 1, &endptr, 10);
+            }
+            if (*endptr != '\0' || prefetch_percent > 100) {
+                error_exit(ErrorCodes::ArgumentError, "Invalid prefetch, use PERCENT (0 - 100) optionally followed by ',RATE' (hits per minute)");
+            }
+            got_prefetch = true;
+        } else if (string(argv[i]) == "--cache-size" && i < argc - 1) {
+            if (got_cache_size) {
+                error_exit(ErrorCodes::ArgumentError, "Option '--cache-size' cannot be used multiple times");
+            }
+            char *endptr;
+            cache_size = strtoul(argv[++i], &endptr, 10);
+            if (*endptr != '\0' || cache_size < 1 || cache_size > 65536) {
+                error_exit(ErrorCodes::ArgumentError, "Invalid cache size, use number of megabytes (1 - 65536)");
+            }
+            cache_size <<= 20;
+            got_cache_size = true;
         } else if (string(argv[i]) == "-r") {
             if (got_recursion) {
                 error_exit(ErrorCodes::ArgumentError, "Option '-r' cannot be used multiple times");
@@ -87,44 +430,32 @@ void parse_args(const int argc, const char *argv[]) {
             recursion = true;
             got_recursion = true;
         } else if (string(argv[i]) == "-x") {
-            if (got_type) {
-                error_exit(ErrorCodes::ArgumentError, "Option '-x' cannot be used with '-6' or '-t' or used multiple times");
+            if (got_reverse) {
+                error_exit(ErrorCodes::ArgumentError, "Option '-x' cannot be used multiple times");
             }
-            type = RR_TYPE::PTR;
-            got_type = true;
+            add_type(RR_TYPE::PTR);
+            got_reverse = true;
         } else if (string(argv[i]) == "-6") {
-            if (got_type) {
-                error_exit(ErrorCodes::ArgumentError, "Option '-6' cannot be used with '-x' or '-t' or used multiple times");
+            if (got_ipv6) {
+                error_exit(ErrorCodes::ArgumentError, "Option '-6' cannot be used multiple times");
             }
-            type = RR_TYPE::AAAA;
-            got_type = true;
+            add_type(RR_TYPE::AAAA);
+            got_ipv6 = true;
         } else if (string(argv[i]) == "-t" && i < argc - 1) {
             if (got_type) {
-                error_exit(ErrorCodes::ArgumentError, "Option '-t' cannot be used with '-x' or '-6' or used multiple times");
+                error_exit(ErrorCodes::ArgumentError, "Option '-t' cannot be used multiple times");
             }
             i++;
-            string type_arg = string(argv[i]);
-            transform(type_arg.begin(), type_arg.end(), type_arg.begin(), ::toupper);
-            if (type_arg == "A") {
-                type = RR_TYPE::A;
-            } else if (type_arg == "NS") {
-                type = RR_TYPE::NS;
-            } else if (type_arg == "CNAME") {
-                type = RR_TYPE::CNAME;
-            } else if (type_arg == "SOA") {
-                type = RR_TYPE::SOA;
-            } else if (type_arg == "PTR") {
-                type = RR_TYPE::PTR;
-            } else if (type_arg == "MX") {
-                type = RR_TYPE::MX;
-            } else if (type_arg == "TXT") {
-                type = RR_TYPE::TXT;
-            } else if (type_arg == "AAAA") {
-                type = RR_TYPE::AAAA;
-            } else if (type_arg == "ANY") {
-                type = RR_TYPE::ANY;
-            } else {
-                error_exit(ErrorCodes::ArgumentError, "Invalid type, TYPE value must be one of: A, NS, CNAME, SOA, PTR, MX, TXT, AAAA, ANY");
+            string type_list = string(argv[i]);
+            transform(type_list.begin(), type_list.end(), type_list.begin(), ::toupper);
+            size_t start = 0;
+            while (true) {
+                const size_t end = min(type_list.find(',', start), type_list.length());
+                add_type(parse_type(type_list.substr(start, end - start)));
+                if (end == type_list.length()) {
+                    break;
+                }
+                start = end + 1;
             }
             got_type = true;
         } else {
@@ -136,34 +467,1019 @@ void parse_args(const int argc, const char *argv[]) {
         }
     }
 
+    if (servers.size() > 1 && !got_compare) {
+        error_exit(ErrorCodes::ArgumentError, "Option '-s' cannot be used multiple times");
+    }
+    if (got_queries && !got_compare) {
+        error_exit(ErrorCodes::ArgumentError, "Option '--queries' can be used only with option '--compare'");
+    }
+    if (got_replay_speed && !got_replay) {
+        error_exit(ErrorCodes::ArgumentError, "Option '--replay-speed' can be used only with option '--replay'");
+    }
+    if (got_nx_fp && !got_nx_filter) {
+        error_exit(ErrorCodes::ArgumentError, "Option '--nx-fp' can be used only with option '--nx-filter'");
+    }
+    if (got_nx_filter && (got_listen || got_compare)) {
+        error_exit(ErrorCodes::ArgumentError, "Option '--nx-filter' cannot be combined with options '--listen' and '--compare'");
+    }
+    if (got_spill && !got_summary) {
+        error_exit(ErrorCodes::ArgumentError, "Option '--spill' can be used only with option '--summary'");
+    }
+    if (got_summary && (got_listen || got_compare || (got_replay && addresses.empty()))) {
+        error_exit(ErrorCodes::ArgumentError, "Option '--summary' requires ADDRESS and cannot be combined with options '--listen' and '--compare'");
+    }
+    if (got_unordered && !got_pipeline) {
+        error_exit(ErrorCodes::ArgumentError, "Option '--unordered' can be used only with option '--pipeline'");
+    }
+    if (got_pipeline && (got_listen || got_compare || (got_replay && addresses.empty()))) {
+        error_exit(ErrorCodes::ArgumentError, "Option '--pipeline' requires ADDRESS and cannot be combined with options '--listen' and '--compare'");
+    }
+    if (got_replay && (got_server || got_port || got_compare)) {
+        error_exit(ErrorCodes::ArgumentError, "Option '--replay' cannot be combined with options '-s', '-p' and '--compare'");
+    }
+    if (!servers.empty()) {
+        server = servers[0];
+    }
+    // server on loopback is started with ephemeral port before the first query
+    if (got_replay) {
+        server = "127.0.0.1";
+    }
+
+    // server given by -s needs no system configuration, cache file is used only to look up its hostname
+    const bool got_config = !got_server && resolver_config_load(config);
+    if (any_of(servers.begin(), servers.end(), [](const string& host) { return !server_address_literal(host); })) {
+        resolver_cache_open(resolver_cache_default_path());
+    }
+    if (got_compare && servers.empty() && got_config) {
+        servers = config.nameservers;
+    }
     if (server.empty()) {
-        server = dns_get_default_server();
-        if (server.empty()) {
+        if (!got_config) {
             error_exit(ErrorCodes::ArgumentError, "Failed to obtain system configured DNS server, use option '-s SERVER' to specify server manually");
         }
+        // with option rotate, runs of program spread over all nameservers
+        server = config.nameservers[config.rotate ? static_cast<size_t>(getpid()) % config.nameservers.size() : 0];
         cout << "Default DNS server: " << server << endl;
     }
 
-    if (addresses.empty()) {
+    if (got_compare && got_listen) {
+        error_exit(ErrorCodes::ArgumentError, "Option '--compare' cannot be combined with option '--listen'");
+    }
+    if (got_prefetch && !got_listen) {
+        error_exit(ErrorCodes::ArgumentError, "Option '--prefetch' can be used only with option '--listen'");
+    }
+    if (got_cache_size && !got_listen) {
+        error_exit(ErrorCodes::ArgumentError, "Option '--cache-size' can be used only with option '--listen'");
+    }
+
+    if (got_listen) {
+        if (!addresses.empty() || got_type || got_ipv6 || got_reverse || got_recursion) {
+            error_exit(ErrorCodes::ArgumentError, "Option '--listen' cannot be combined with 'ADDRESS', '-r', '-6', '-x' or '-t'");
+        }
+        return;
+    }
+
+    if (addresses.empty() && !got_queries && !got_replay) {
         error_exit(ErrorCodes::ArgumentError, "Argument 'ADDRESS' is required");
     }
+    if (types.empty()) {
+        types.push_back(RR_TYPE::A);
+    }
+    for (const RR_TYPE type : types) {
+        if ((type == RR_TYPE::AXFR || type == RR_TYPE::IXFR) && (types.size() > 1 || addresses.size() > 1 || got_compare || got_replay)) {
+            error_exit(ErrorCodes::ArgumentError, "Zone transfer cannot be combined with other types, multiple addresses or options '--compare' and '--replay'");
+        }
+    }
+
+    const bool got_ptr = any_of(types.begin(), types.end(), [](const RR_TYPE type) { return type == RR_TYPE::PTR; });
+    for (const auto& address : addresses) {
+        if (!ReverseSweep::isRange(address)) {
+            // library queries root name for address that cannot be reversed
+            if (got_ptr && getInverseName(address) == ".") {
+                warning_print("Address '" + address + "' is not valid IPv4 or IPv6 address");
+            }
+            continue;
+        }
+        if (got_compare) {
+            error_exit(ErrorCodes::ArgumentError, "Address range '" + address + "' cannot be used with option '--compare'");
+        }
+        if (types.size() != 1 || types[0] != RR_TYPE::PTR) {
+            error_exit(ErrorCodes::ArgumentError, "Address range '" + address + "' can be used only with option '-x' without other types");
+        }
+        ReverseSweep sweep;
+        if (!sweep.parse(address)) {
+            error_exit(ErrorCodes::ArgumentError, "Address range '" + address + "' is not valid IPv4 or IPv6 CIDR range");
+        }
+        if (sweep.isTruncated()) {
+            warning_print("Address range '" + address + "' is limited to first " + to_string(MAX_SWEEP_ADDRESSES) + " addresses");
+        }
+    }
+}
+
+/**
+ * @brief Signal handler, resolution of addresses is stopped by flag and program returns normally (filter of
+ * '--nx-filter' is saved outside of handler), other modes exit, statistics and trace are written in both cases
+ * @param signal received signal
+ */
+void sig_handler(const int signal) {
+    if (signal == SIGINT) {
+        interrupted = 1;
+        if (!interrupt_checked) {
+            exit(0);
+        }
+    }
+}
+
+/**
+ * @brief Blocks SIGINT in thread of pipeline stage, so the signal interrupts poll of I/O stage
+ */
+void block_interrupt() {
+#if !defined(_WIN32) && !defined(_WIN64)
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+#endif
+}
+
+/**
+ * @brief Exits program with error message when resolver operation failed
+ * @param status status of resolver operation
+ * @param error error message of operation (getError of resolver or transfer)
+ */
+void check_status(const ResolverStatus status, const string& error) {
+    switch (status) {
+        case ResolverStatus::Ok:
+        case ResolverStatus::Interrupted:
+            return;
+        case ResolverStatus::ServerError:
+            error_exit(ErrorCodes::SocketError, "Server - " + error);
+            break;
+        case ResolverStatus::SocketError:
+        case ResolverStatus::NotOpen:
+            error_exit(ErrorCodes::SocketError, resolver_status_string(status));
+            break;
+        case ResolverStatus::Timeout:
+            error_exit(ErrorCodes::TimeoutError, "Response timeout " + to_string(config.timeout * config.attempts) + "s");
+            break;
+        case ResolverStatus::ProtocolError:
+            error_exit(ErrorCodes::TransferError, string(resolver_status_string(status)) + " - " + error);
+            break;
+        default:
+            error_exit(ErrorCodes::TransferError, resolver_status_string(status));
+            break;
+    }
+}
+
+/**
+ * @brief Checks whether address is expanded by search list, reverse lookups and address ranges are not
+ * @param address address from arguments
+ * @param type type of query
+ * @return true if address is expanded
+ */
+bool expands_by_search(const string& address, const RR_TYPE type) {
+    return type != RR_TYPE::PTR && !ReverseSweep::isRange(address);
+}
+
+/**
+ * @brief Checks name of bulk run in filter of option '--nx-filter'
+ * @param name name to query
+ * @return true when name is known not to exist and its query is skipped
+ */
+bool skip_known_nonexistent(const string& name) {
+    if (!nx_filter) {
+        return false;
+    }
+    {
+        const lock_guard<mutex> lock(nx_filter_mutex);
+        if (!nx_filter->contains(name)) {
+            return false;
+        }
+    }
+    stats_count(Counter::NegativeSkips);
+    warning_print("Name '" + name + "' is known not to exist, query skipped");
+    return true;
+}
+
+/**
+ * @brief Adds name of NXDOMAIN response to filter of option '--nx-filter' for negative TTL of response (SOA minimum)
+ * @param response response from server
+ */
+void remember_nonexistent(const DNSPacket& response) {
+    if (!nx_filter || response.getHeader().getRcode() != 3 || response.getHeader().getQdcount() == 0) {
+        return;
+    }
+    bool cacheable;
+    const uint32_t ttl = AnswerCache::responseTtl(response, cacheable);
+    if (cacheable) {
+        const lock_guard<mutex> lock(nx_filter_mutex);
+        nx_filter->add(response.getQuestion().getName(), ttl);
+    }
+}
+
+/**
+ * @brief Saves filter of option '--nx-filter' after all queries (also interrupted ones) are done
+ */
+void nx_filter_save() {
+    string error;
+    if (nx_filter && !nx_filter->save(nx_filter_file, error)) {
+        warning_print(error);
+    }
+}
+
+/**
+ * @brief Loads filter of option '--nx-filter', it is saved by nx_filter_save
+ */
+void nx_filter_open() {
+    nx_filter = make_unique<NegativeFilter>(nx_false_positive_rate);
+    string error;
+    if (!nx_filter->load(nx_filter_file, error)) {
+        error_exit(ErrorCodes::InputError, error);
+    }
+}
+
+/**
+ * @brief Prints warnings of response (request packet, error response code, malformed packet, invalid data of records)
+ * @param response parsed response
+ */
+void print_response_warnings(const DNSPacket& response) {
+    response.getHeader().reportWarnings(warning_print);
+    if (response.isMalformed()) {
+        warning_print("Response packet is malformed, records after the malformed one are not printed");
+    }
+    for (const auto* section : {&response.getAnswers(), &response.getAuthorities(), &response.getAdditionals()}) {
+        for (const DNSRecord& record : *section) {
+            if (const char* warning = record.getRdataWarning()) {
+                warning_print(warning);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Keeps answer records of response in store of option '--summary'
+ * @param item output item (address and type) of response
+ * @param response response from server
+ */
+void store_result(const size_t item, const DNSPacket& response) {
+    if (results && !results->add(static_cast<uint32_t>(item), response)) {
+        error_exit(ErrorCodes::MemoryError, results->getError());
+    }
+}
+
+/**
+ * @brief Prints aggregations of store of option '--summary': the most common record data with number of their owners,
+ * histogram of TTL and CNAME chains resolved to canonical names
+ */
+void print_summary() {
+    cout << "Summary: " << results->getRecords() << " records of " << results->getResponses() << " responses, "
+         << results->getNames() << " names, " << (results->getMemory() + 1023) / 1024 << " KiB of store"
+         << (results->isSpilled() ? " (spilled to " + spill_directory + ")" : "") << endl;
+
+    const vector<RdataGroup> groups = results->groupByRdata(RESULTS_SUMMARY_GROUPS);
+    if (!groups.empty()) {
+        cout << "Most common record data:" << endl;
+        cout << "  " << right << setw(10) << "records" << setw(10) << "names" << "  " << left << setw(8) << "type" << "data" << endl;
+        for (const RdataGroup& group : groups) {
+            cout << "  " << right << setw(10) << group.records << setw(10) << group.owners << "  " << left << setw(8)
+                 << RR_TYPE::typeToString(group.type) << group.rdata << endl;
+        }
+    }
+
+    const auto histogram = results->ttlHistogram();
+    if (results->getRecords() > 0) {
+        cout << "TTL histogram:" << endl;
+        for (size_t i = 0; i < histogram.size(); i++) {
+            if (histogram[i] == 0) {
+                continue;
+            }
+            const uint64_t low = i == 0 ? 0 : uint64_t{1} << (i - 1);
+            const uint64_t high = i == 0 ? 0 : (uint64_t{1} << i) - 1;
+            cout << "  " << right << setw(10) << low << " - " << left << setw(10) << high << right << setw(10) << histogram[i]
+                 << "  " << left << string(static_cast<size_t>(40 * histogram[i] / results->getRecords()), '#') << endl;
+        }
+    }
+
+    const vector<CnameChain> chains = results->cnameChains();
+    if (!chains.empty()) {
+        cout << "CNAME chains:" << endl;
+        for (const CnameChain& chain : chains) {
+            cout << "  " << chain.alias << " -> " << chain.canonical << " (" << chain.length
+                 << (chain.length == 1 ? " hop" : " hops") << (chain.loop ? ", loop" : "") << ")" << endl;
+        }
+    }
+}
+
+/**
+ * @brief Response to one candidate name of search list expansion
+ */
+struct CandidateResult {
+    enum class State {
+        Pending,
+        Negative,   // NXDOMAIN, NODATA or other error, next candidate is used
+        Positive,   // answer with records, wins unless candidate with higher priority is positive
+        Timeout,
+    };
+    State state = State::Pending;
+    // copy of header for warnings and formatted response, kept only while response may still be printed
+    DNSHeader header;
+    string text;
+    // copy of response for store of option '--summary'
+    vector<uint8_t> raw;
+};
+
+/**
+ * @brief Address expanded to several candidate names, all of them are sent at once
+ */
+struct CandidateLookup {
+    // candidates in order of priority
+    vector<CandidateResult> results;
+    // rank of name as typed, its response is printed when no candidate is positive
+    size_t as_is = 0;
+    string name;
+    // responses of remaining candidates are ignored once response is printed
+    bool decided = false;
+};
+
+/**
+ * @brief Item of queue from I/O stage to parse stage of option '--pipeline'. Bookkeeping of questions goes through
+ * the same queue as responses, so parse stage knows owner of each response before it gets the response
+ */
+struct ParseEvent {
+    enum class Kind {
+        Owner,      // question of item (rank of candidate) was sent
+        Lookup,     // item is expanded to candidates, rank is number of candidates
+        Skipped,    // name of item is known not to exist
+        Response,
+        Timeout,
+    };
+    Kind kind = Kind::Response;
+    size_t item = 0;
+    uint32_t rank = 0;
+    // rank of name as typed and the name (Lookup)
+    size_t as_is = 0;
+    string name;
+    // index of query, its question and received packet (Response, Timeout)
+    size_t index = 0;
+    DNSQuestion question;
+    vector<uint8_t> packet;
+};
+
+/**
+ * @brief Item of queue from parse stage to output stage of option '--pipeline', formatted output of item
+ */
+struct OutputEvent {
+    size_t item = 0;
+    string text;
+};
+
+/**
+ * @brief Sends requests for all addresses (and address ranges) pipelined, responses are printed in order of addresses.
+ * Address expanded by search list sends all its candidates at once, the positive answer of candidate with the highest
+ * priority is printed as soon as all candidates with higher priority are known to be negative.
+ * With option '--pipeline' this thread only sends and receives (I/O stage), responses are parsed and formatted
+ * by parse stage and written by output stage, each in its own thread connected by SPSC queues
+ * @param resolver open resolver
+ * @param arena arena for parsed responses
+ */
+void dns_resolver_bulk(Resolver& resolver, Arena& arena) {
+    size_t address_index = 0;
+    ReverseSweep sweep;
+    bool sweeping = false;
+    string name;
+
+    /**
+     * @brief Question of current address not sent yet
+     */
+    struct QueuedQuestion {
+        string name;
+        RR_TYPE type;
+        size_t item;
+        uint32_t rank;
+        // item has more than one candidate
+        bool expanded;
+    };
+    // questions of all types and candidates of current address
+    vector<QueuedQuestion> queued;
+    size_t next_queued = 0;
+
+    // output item (pair of address and type, or name of range) and rank of candidate of each question, by index of question
+    vector<pair<size_t, uint32_t>> owners;
+    // items with more than one candidate
+    map<size_t, CandidateLookup> lookups;
+    size_t items = 0;
+
+    // output of items completed before preceding items waits here, to keep output order
+    map<size_t, string> waiting;
+    size_t next_print = 0;
+
+    // queues between stages of option '--pipeline'
+    unique_ptr<SpscRing<ParseEvent>> parse_queue;
+    unique_ptr<SpscRing<OutputEvent>> output_queue;
+    if (got_pipeline) {
+        parse_queue = make_unique<SpscRing<ParseEvent>>(PIPELINE_QUEUE_SIZE, Queue::Parse);
+        output_queue = make_unique<SpscRing<OutputEvent>>(PIPELINE_QUEUE_SIZE, Queue::Output);
+    }
+    // events I/O stage could not queue because parse stage is behind, I/O stage must not wait for it
+    // (responses would wait in socket and retransmissions would be late), new queries are not sent until it is empty
+    deque<ParseEvent> overflow;
+
+    auto forward_event = [&](auto&& fill) {
+        if (overflow.empty() && parse_queue->tryPush(fill)) {
+            return;
+        }
+        fill(overflow.emplace_back());
+    };
+
+    auto drain_overflow = [&]() {
+        while (!overflow.empty() && parse_queue->tryPush([&](ParseEvent& event) { event = move(overflow.front()); })) {
+            overflow.pop_front();
+        }
+    };
+
+    auto print_waiting = [&]() {
+        next_print++;
+        if (!waiting.empty()) {
+            StageTimer print_timer(Stage::Print);
+            for (auto it = waiting.begin(); it != waiting.end() && it->first == next_print; it = waiting.erase(it)) {
+                cout << it->second;
+                next_print++;
+            }
+            cout.flush();
+        }
+    };
+
+    // output of item waits for preceding items, with option '--unordered' it is written at once
+    auto write_output = [&](const size_t item, string& text) {
+        if (got_unordered) {
+            cout << text;
+            return;
+        }
+        if (item != next_print) {
+            waiting.emplace(item, move(text));
+            return;
+        }
+        cout << text;
+        print_waiting();
+    };
+
+    auto output_text = [&](const size_t item, string text) {
+        if (output_queue) {
+            output_queue->push([&](OutputEvent& event) {
+                event.item = item;
+                event.text = move(text);
+            });
+            return;
+        }
+        write_output(item, text);
+    };
+
+    // query is number of the query in trace events, print stage is joined to its spans
+    auto output_response = [&](const size_t item, const uint64_t query, const DNSPacket& response) {
+        print_response_warnings(response);
+        store_result(item, response);
+        if (output_queue) {
+            output_queue->push([&](OutputEvent& event) {
+                StageTimer print_timer(Stage::Print, query);
+                pmr::string out(response.getResource());
+                dns_format(response, out);
+                event.item = item;
+                event.text.assign(out.data(), out.size());
+            });
+            return;
+        }
+        StageTimer print_timer(Stage::Print, query);
+        if (item != next_print) {
+            pmr::string out(response.getResource());
+            dns_format(response, out);
+            waiting.emplace(item, string(out.data(), out.size()));
+            return;
+        }
+        dns_print(response);
+        print_waiting();
+    };
+
+    auto format_response = [](const DNSPacket& response) {
+        pmr::string out(response.getResource());
+        dns_format(response, out);
+        return string(out.data(), out.size());
+    };
+
+    auto create_lookup = [&](const size_t item, const size_t candidates, const size_t as_is, const string& address) {
+        CandidateLookup& lookup = lookups[item];
+        lookup.results.resize(candidates);
+        lookup.as_is = as_is;
+        lookup.name = address;
+    };
+
+    auto print_response = [&](const size_t index, const DNSQuestion& question, const DNSPacket* response) {
+        const auto [item, rank] = owners[index];
+        if (response != nullptr) {
+            remember_nonexistent(*response);
+        }
+        const auto it = lookups.find(item);
+        if (it == lookups.end()) {
+            if (response == nullptr) {
+                warning_print("Response timeout for '" + question.getNameDot() + "'");
+                output_text(item, "");
+            } else {
+                output_response(item, resolver.traceId(index), *response);
+            }
+            return;
+        }
+
+        CandidateLookup& lookup = it->second;
+        if (lookup.decided) {
+            return;
+        }
+        CandidateResult& result = lookup.results[rank];
+        if (response == nullptr) {
+            result.state = CandidateResult::State::Timeout;
+        } else {
+            const DNSHeader& header = response->getHeader();
+            result.state = header.getRcode() == 0 && header.getAncount() > 0 ? CandidateResult::State::Positive
+                                                                             : CandidateResult::State::Negative;
+            result.header = header;
+        }
+
+        // winner is the first positive candidate with all candidates of higher priority negative,
+        // name as typed when all candidates are negative
+        size_t winner = lookup.as_is;
+        for (size_t i = 0; i < lookup.results.size(); i++) {
+            if (lookup.results[i].state == CandidateResult::State::Pending) {
+                // undecided, keep response that may still be printed
+                if (response != nullptr && (result.state == CandidateResult::State::Positive || rank == lookup.as_is)) {
+                    result.text = format_response(*response);
+                    if (results) {
+                        result.raw.assign(response->getRaw(), response->getRaw() + response->getRawLength());
+                    }
+                }
+                return;
+            }
+            if (lookup.results[i].state == CandidateResult::State::Positive) {
+                winner = i;
+                break;
+            }
+        }
+
+        CandidateResult& won = lookup.results[winner];
+        if (winner == rank && response != nullptr) {
+            output_response(item, resolver.traceId(index), *response);
+        } else if (won.state == CandidateResult::State::Timeout) {
+            warning_print("Response timeout for '" + lookup.name + "'");
+            output_text(item, "");
+        } else {
+            won.header.reportWarnings(warning_print);
+            if (!won.raw.empty()) {
+                store_result(item, DNSPacket(won.raw.data(), won.raw.size()));
+            }
+            output_text(item, move(won.text));
+        }
+        lookup.decided = true;
+        lookup.results = {};
+    };
+
+    // bookkeeping of questions is done by parse stage, with option '--pipeline' it is queued in order with responses
+    auto add_owner = [&](const size_t item, const uint32_t rank) {
+        if (parse_queue) {
+            forward_event([&](ParseEvent& event) {
+                event.kind = ParseEvent::Kind::Owner;
+                event.item = item;
+                event.rank = rank;
+            });
+            return;
+        }
+        owners.emplace_back(item, rank);
+    };
+
+    auto add_lookup = [&](const size_t item, const size_t candidates, const size_t as_is, const string& address) {
+        if (parse_queue) {
+            forward_event([&](ParseEvent& event) {
+                event.kind = ParseEvent::Kind::Lookup;
+                event.item = item;
+                event.rank = static_cast<uint32_t>(candidates);
+                event.as_is = as_is;
+                event.name = address;
+            });
+            return;
+        }
+        create_lookup(item, candidates, as_is, address);
+    };
+
+    auto skip_item = [&](const size_t item) {
+        if (parse_queue) {
+            forward_event([&](ParseEvent& event) {
+                event.kind = ParseEvent::Kind::Skipped;
+                event.item = item;
+            });
+            return;
+        }
+        output_text(item, "");
+    };
+
+    auto next_question = [&](DNSQuestion& question) {
+        while (true) {
+            if (next_queued < queued.size()) {
+                const QueuedQuestion& next = queued[next_queued++];
+                // names of search expansion are decided together, only names queried as typed are skipped
+                if (!next.expanded && skip_known_nonexistent(next.name)) {
+                    skip_item(next.item);
+                    continue;
+                }
+                add_owner(next.item, next.rank);
+                question = DNSQuestion(next.name, next.type);
+                return true;
+            }
+            if (sweeping && sweep.next(name)) {
+                if (skip_known_nonexistent(name)) {
+                    skip_item(items++);
+                    continue;
+                }
+                add_owner(items++, 0);
+                question = DNSQuestion(name, static_cast<uint16_t>(RR_TYPE::PTR), 0x0001);
+                return true;
+            }
+            sweeping = false;
+            if (address_index == addresses.size()) {
+                return false;
+            }
+            const string& address = addresses[address_index++];
+            if (ReverseSweep::isRange(address)) {
+                sweeping = sweep.parse(address);
+                continue;
+            }
+            // items of one address are consecutive, so its responses are printed together in order of types
+            queued.clear();
+            next_queued = 0;
+            for (const RR_TYPE type : types) {
+                const vector<string> candidates = expands_by_search(address, type) ? config.candidates(address)
+                                                                                  : vector<string>{address};
+                const bool expanded = candidates.size() > 1;
+                if (expanded) {
+                    add_lookup(items, candidates.size(),
+                               static_cast<size_t>(find(candidates.begin(), candidates.end(), address) - candidates.begin()), address);
+                }
+                for (size_t rank = 0; rank < candidates.size(); rank++) {
+                    queued.push_back({candidates[rank], type, items, static_cast<uint32_t>(rank), expanded});
+                }
+                items++;
+            }
+        }
+    };
+
+    if (!got_pipeline) {
+        check_status(resolver.sendWindow(next_question, print_response, recursion, static_cast<size_t>(window), &arena), resolver.getError());
+        return;
+    }
+
+    // output stage writes formatted responses, output is flushed before the stage waits for the next one
+    thread output_stage([&]() {
+        block_interrupt();
+        while (output_queue->pop([&](OutputEvent& event) { write_output(event.item, event.text); })) {
+            if (output_queue->empty()) {
+                cout.flush();
+            }
+        }
+        cout.flush();
+    });
+
+    // parse stage parses responses in its own arena and decides output of each item
+    thread parse_stage([&]() {
+        block_interrupt();
+        Arena parse_arena;
+        size_t batched = 0;
+        while (parse_queue->pop([&](const ParseEvent& event) {
+            switch (event.kind) {
+                case ParseEvent::Kind::Owner:
+                    owners.emplace_back(event.item, event.rank);
+                    break;
+                case ParseEvent::Kind::Lookup:
+                    create_lookup(event.item, event.rank, event.as_is, event.name);
+                    break;
+                case ParseEvent::Kind::Skipped:
+                    output_text(event.item, "");
+                    break;
+                case ParseEvent::Kind::Timeout:
+                    print_response(event.index, event.question, nullptr);
+                    break;
+                case ParseEvent::Kind::Response: {
+                    if (batched++ == ARENA_BATCH_SIZE) {
+                        parse_arena.reset();
+                        batched = 1;
+                    }
+                    StageTimer parse_timer(Stage::Parse, resolver.traceId(event.index));
+                    const DNSPacket response(event.packet.data(), event.packet.size(), &parse_arena);
+                    parse_timer.stop();
+                    print_response(event.index, event.question, &response);
+                    break;
+                }
+            }
+        })) {
+        }
+        output_queue->close();
+    });
+
+    // I/O stage only matches responses to queries and passes their packets on
+    const RawResponseHandler forward_response = [&](const size_t index, const DNSQuestion& question, const uint8_t* packet,
+                                                    const size_t length) {
+        forward_event([&](ParseEvent& event) {
+            event.kind = packet != nullptr ? ParseEvent::Kind::Response : ParseEvent::Kind::Timeout;
+            event.index = index;
+            event.question = question;
+            if (packet != nullptr) {
+                event.packet.assign(packet, packet + length);
+            }
+        });
+    };
+
+    // window of the resolver is driven here instead of sendWindowRaw, so sending of new queries pauses while
+    // parse stage is behind and receiving and retransmissions go on
+    ResolverStatus status = resolver.openWindow(static_cast<size_t>(window));
+    bool exhausted = false;
+    while (status == ResolverStatus::Ok) {
+        if (interrupted) {
+            status = ResolverStatus::Interrupted;
+            break;
+        }
+        drain_overflow();
+        while (!exhausted && overflow.empty() && !resolver.windowFull() && status == ResolverStatus::Ok) {
+            DNSQuestion question;
+            if (!next_question(question)) {
+                exhausted = true;
+                break;
+            }
+            size_t index;
+            status = resolver.submit(question, recursion, index);
+        }
+        if (status != ResolverStatus::Ok || (exhausted && resolver.windowEmpty())) {
+            break;
+        }
+
+        pollfd fds{};
+        fds.fd = resolver.getSocket();
+        fds.events = POLLIN;
+        int timeout = resolver.windowTimeout();
+        // token of pacer that became available after windowFull gives no timeout, next question is sent right away
+        if (timeout < 0 && !exhausted && overflow.empty()) {
+            timeout = 0;
+        } else if (!overflow.empty()) {
+            timeout = timeout < 0 ? PIPELINE_RETRY_MS : min(timeout, PIPELINE_RETRY_MS);
+        }
+        StageTimer wait_timer(Stage::Wait);
+        const int ready = poll(&fds, 1, timeout);
+        wait_timer.stop();
+        if (ready > 0 && (fds.revents & POLLIN)) {
+            status = resolver.receiveRaw(forward_response);
+        }
+        if (status == ResolverStatus::Ok) {
+            status = resolver.expireRaw(forward_response);
+        }
+    }
+    // I/O is done, the rest can wait for parse stage
+    for (ParseEvent& event : overflow) {
+        parse_queue->push([&](ParseEvent& slot) { slot = move(event); });
+    }
+    parse_queue->close();
+    parse_stage.join();
+    output_stage.join();
+    check_status(status, resolver.getError());
+}
+
+/**
+ * @brief Transfers zone over TCP and prints its records as they arrive, followed by summary of transfer
+ */
+void dns_zone_transfer() {
+    ZoneTransfer transfer;
+    check_status(transfer.open(server, static_cast<uint16_t>(port)), transfer.getError());
+
+    if (signal(SIGINT, sig_handler) == SIG_ERR) {
+        error_exit(ErrorCodes::SignalError, "Signal handler for 'SIGINT' registration failed");
+    }
+
+    // names are aligned to the longest name seen so far, output of record is written right away
+    size_t longest_name = 0;
+    pmr::string out;
+    const RecordHandler print_record = [&](const DNSRecord& record) {
+        StageTimer print_timer(Stage::Print, 1);
+        longest_name = max(longest_name, record.getNameView().length());
+        out.clear();
+        if (const char* warning = record.getRdataWarning()) {
+            warning_print(warning);
+        }
+        dns_format_record(record, longest_name, out);
+        cout.write(out.data(), static_cast<streamsize>(out.size()));
+    };
+
+    const ResolverStatus status = transfer.run(addresses[0], types[0], transfer_serial, print_record, config.timeout * 1000);
+    cout.flush();
+    check_status(status, transfer.getError());
+
+    const TransferSummary& summary = transfer.getSummary();
+    if (summary.up_to_date) {
+        cout << "Zone is up to date, serial " << summary.serial << endl;
+    }
+    cout << "Transfer complete: " << summary.records << " records in " << summary.messages << " messages ("
+         << summary.bytes << " bytes), serial " << summary.serial << endl;
+}
+
+/**
+ * @brief Sets options of resolver given by arguments, before resolver is opened
+ * @param resolver resolver of server
+ */
+void configure_resolver(Resolver& resolver) {
+    resolver.setWarningHandler(warning_print);
+    resolver.setPacing(pacing);
+    resolver.setTimestamps(got_timestamps);
+    resolver.setIoUring(got_io_uring);
+    if (got_record) {
+        resolver.setRecorder(&recorder);
+    }
+}
+
+/**
+ * @brief Reads queries of comparison from file, each line is name optionally followed by TYPE[,TYPE...],
+ * name without types is queried with types of options
+ * @param path path of file
+ * @param queries output queries in order of file
+ */
+void load_compare_queries(const string& path, vector<CompareQuery>& queries) {
+    ifstream file(path);
+    if (!file.is_open()) {
+        error_exit(ErrorCodes::InputError, "Queries file '" + path + "' cannot be opened");
+    }
+    string line;
+    size_t line_number = 0;
+    while (getline(file, line)) {
+        line_number++;
+        istringstream fields(line);
+        string name;
+        string type_list;
+        if (!(fields >> name) || name[0] == '#') {
+            continue;
+        }
+        if (!(fields >> type_list)) {
+            for (const RR_TYPE type : types) {
+                queries.push_back({name, type});
+            }
+            continue;
+        }
+        transform(type_list.begin(), type_list.end(), type_list.begin(), ::toupper);
+        size_t start = 0;
+        while (start <= type_list.length()) {
+            const size_t end = min(type_list.find(',', start), type_list.length());
+            const RR_TYPE type = parse_type(type_list.substr(start, end - start));
+            if (type == RR_TYPE::AXFR || type == RR_TYPE::IXFR) {
+                error_exit(ErrorCodes::InputError, "Zone transfer on line " + to_string(line_number) + " of queries file cannot be compared");
+            }
+            queries.push_back({name, type});
+            start = end + 1;
+        }
+    }
+    if (queries.empty()) {
+        error_exit(ErrorCodes::InputError, "Queries file '" + path + "' does not contain any query");
+    }
+}
+
+/**
+ * @brief Loads session log of option '--replay' and starts replay server on loopback, queries are sent to it,
+ * recorded questions are kept for run without ADDRESS
+ */
+void dns_replay_start() {
+    vector<SessionRecord> records;
+    string error;
+    if (!load_session(replay_file, records, error)) {
+        error_exit(ErrorCodes::InputError, error);
+    }
+    Arena arena;
+    for (const auto& record : records) {
+        if (record.query.size() < sizeof(WireHeader)) {
+            continue;
+        }
+        arena.reset();
+        WireReader reader(record.query.data(), record.query.size(), sizeof(WireHeader));
+        const DNSQuestion question(reader, &arena);
+        if (reader.isValid()) {
+            replay_queries.push_back({string(question.getName()), static_cast<RR_TYPE::Type>(question.getType())});
+        }
+    }
+    if (!replay_server.start(move(records), replay_speed, error)) {
+        error_exit(ErrorCodes::SocketError, error);
+    }
+    port = replay_server.getPort();
+    cout << "Replaying " << replay_queries.size() << " recorded queries from '" << replay_file << "' on 127.0.0.1:" << port << endl;
+}
+
+/**
+ * @brief Sends queries of arguments and queries file to all servers and prints comparison of servers
+ */
+void dns_compare_servers() {
+    vector<CompareQuery> queries;
+    for (const auto& address : addresses) {
+        for (const RR_TYPE type : types) {
+            queries.push_back({address, type});
+        }
+    }
+    if (got_queries) {
+        load_compare_queries(queries_file, queries);
+    }
+    if (got_replay && queries.empty()) {
+        queries = replay_queries;
+        servers = {server};
+    }
+
+    if (signal(SIGINT, sig_handler) == SIG_ERR) {
+        error_exit(ErrorCodes::SignalError, "Signal handler for 'SIGINT' registration failed");
+    }
+    string error;
+    check_status(dns_compare(servers, static_cast<uint16_t>(port), queries, static_cast<size_t>(window), recursion,
+                             configure_resolver, error), error);
 }
 
 /**
  * @brief Runs dns resolver program with given arguments, then prints response from server to stdout
  */
 void dns_resolver() {
-    dns_init(server, static_cast<uint16_t>(port));
+    if (got_replay) {
+        dns_replay_start();
+        if (addresses.empty()) {
+            dns_compare_servers();
+            return;
+        }
+    }
+    if (got_compare) {
+        dns_compare_servers();
+        return;
+    }
+    if (!got_listen && (types[0] == RR_TYPE::AXFR || types[0] == RR_TYPE::IXFR)) {
+        dns_zone_transfer();
+        return;
+    }
 
-    for (const auto& address : addresses) {
-        DNSPacket packet = DNSPacket(DNSHeader(recursion), DNSQuestion(address, type));
+    Resolver resolver;
+    configure_resolver(resolver);
+    check_status(resolver.open(server, static_cast<uint16_t>(port)), resolver.getError());
+
+    if (signal(SIGINT, sig_handler) == SIG_ERR) {
+        error_exit(ErrorCodes::SignalError, "Signal handler for 'SIGINT' registration failed");
+    }
+
+    if (got_listen) {
+        check_status(dns_forwarder(resolver, listen_address, listen_port, static_cast<size_t>(window),
+                                   static_cast<unsigned>(prefetch_percent), static_cast<unsigned>(prefetch_rate), static_cast<size_t>(cache_size)),
+                     resolver.getError());
+        return;
+    }
+
+    // from now on SIGINT only stops queries, so filter is not saved by exit handler while its lock is held
+    resolver.setInterrupt(&interrupted);
+    interrupt_checked = 1;
 
-        packet = dns_send(packet);
+    if (got_nx_filter) {
+        nx_filter_open();
+    }
+
+    if (got_summary) {
+        results = make_unique<ResultStore>(spill_directory);
+    }
+
+    // responses and their formatted output are allocated from arena, which is reset after each batch
+    Arena arena;
+
+    if (addresses.size() > 1 || types.size() > 1 || ReverseSweep::isRange(addresses[0]) ||
+        (expands_by_search(addresses[0], types[0]) && config.candidates(addresses[0]).size() > 1)) {
+        dns_resolver_bulk(resolver, arena);
+    } else {
+        const DNSPacket packet = DNSPacket(DNSHeader(recursion), DNSQuestion(addresses[0], types[0]));
 
-        dns_print(packet);
+        optional<DNSPacket> response;
+        // each attempt waits for timeout of system configuration (resolv.conf options timeout and attempts)
+        // every attempt is query of its own (index in traces), response belongs to the last one
+        ResolverStatus status = ResolverStatus::Timeout;
+        int attempts = 0;
+        while (attempts < config.attempts && status == ResolverStatus::Timeout) {
+            status = resolver.send(packet, response, &arena, config.timeout * 1000);
+            attempts++;
+        }
+        check_status(status, resolver.getError());
+        if (status == ResolverStatus::Interrupted) {
+            nx_filter_save();
+            return;
+        }
+        if (response->getHeader().getId() != packet.getHeader().getId()) {
+            warning_print("ID of response packet does not match ID of request packet");
+        }
+        print_response_warnings(*response);
+
+        remember_nonexistent(*response);
+        store_result(0, *response);
+        StageTimer print_timer(Stage::Print, resolver.traceId(static_cast<size_t>(attempts - 1)));
+        dns_print(*response);
     }
 
-    dns_close();
+    if (results) {
+        print_summary();
+    }
+    nx_filter_save();
 }
 
 int main(const int argc, const char *argv[]) {
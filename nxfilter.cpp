@@ -0,0 +1,260 @@
+/**
+ * @file nxfilter.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of persistent filter of known nonexistent names (NXDOMAIN), part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "nxfilter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "dns.h"
+#include "stats.h"
+
+using namespace std;
+
+/**
+ * @brief Entry of filter file, all entries follow magic
+ */
+struct WireNegativeEntry {
+    BigEndian<uint64_t> hash;
+    BigEndian<uint32_t> expires;
+};
+
+/**
+ * @brief Current time of system clock, expiry survives between runs
+ * @return seconds since Unix epoch
+ */
+static uint32_t unix_now() {
+    return static_cast<uint32_t>(chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief Second hash for probes of the first tier, independent of bits of the first one (splitmix64 finalizer)
+ * @param hash hash of name
+ * @return step between probes, odd
+ */
+static uint64_t probe_step(uint64_t hash) {
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111eb;
+    return (hash ^ (hash >> 31)) | 1;
+}
+
+/**
+ * @brief Creates empty filter
+ * @param false_positive_rate probability that name not in filter passes the first tier (sets its size and number of probes)
+ */
+NegativeFilter::NegativeFilter(const double false_positive_rate) : false_positive_rate(false_positive_rate) {
+    rebuild(NXFILTER_MIN_CAPACITY);
+}
+
+/**
+ * @brief Case insensitive hash of name without trailing dot (FNV-1a)
+ * @param name domain name
+ * @return 64-bit hash
+ */
+uint64_t NegativeFilter::nameHash(string_view name) {
+    if (!name.empty() && name.back() == '.') {
+        name.remove_suffix(1);
+    }
+    uint64_t value = 0xcbf29ce484222325;
+    for (const char c : name) {
+        value ^= static_cast<uint8_t>(tolower(static_cast<unsigned char>(c)));
+        value *= 0x100000001b3;
+    }
+    return value;
+}
+
+/**
+ * @brief Sizes the first tier for capacity names and configured false positive rate (m = -n ln p / ln^2 2, k = m / n ln 2)
+ * and fills it from exact tier
+ * @param new_capacity number of names
+ */
+void NegativeFilter::rebuild(const size_t new_capacity) {
+    capacity = max(new_capacity, NXFILTER_MIN_CAPACITY);
+    const double ln2 = log(2.0);
+    slots = static_cast<size_t>(ceil(-static_cast<double>(capacity) * log(false_positive_rate) / (ln2 * ln2)));
+    slots += slots & 1;
+    probes = max(1u, static_cast<unsigned>(lround(static_cast<double>(slots) / static_cast<double>(capacity) * ln2)));
+    counters.assign(slots / 2, 0);
+    for (const auto& entry : exact) {
+        increment(entry.first);
+    }
+}
+
+/**
+ * @brief Checks the first tier
+ * @param hash hash of name
+ * @return false when name is certainly not in filter
+ */
+bool NegativeFilter::mayContain(const uint64_t hash) const {
+    const uint64_t step = probe_step(hash);
+    for (unsigned i = 0; i < probes; i++) {
+        const size_t slot = (hash + i * step) % slots;
+        if (((counters[slot / 2] >> (slot & 1) * 4) & 0x0f) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Increments counters of name in the first tier, saturated counter stays at maximum
+ * @param hash hash of name
+ */
+void NegativeFilter::increment(const uint64_t hash) {
+    const uint64_t step = probe_step(hash);
+    for (unsigned i = 0; i < probes; i++) {
+        const size_t slot = (hash + i * step) % slots;
+        const unsigned shift = (slot & 1) * 4;
+        if (((counters[slot / 2] >> shift) & 0x0f) < NXFILTER_COUNTER_MAX) {
+            counters[slot / 2] = static_cast<uint8_t>(counters[slot / 2] + (1 << shift));
+        }
+    }
+}
+
+/**
+ * @brief Decrements counters of removed name, saturated counter is not decremented because its true count is unknown
+ * @param hash hash of name
+ */
+void NegativeFilter::decrement(const uint64_t hash) {
+    const uint64_t step = probe_step(hash);
+    for (unsigned i = 0; i < probes; i++) {
+        const size_t slot = (hash + i * step) % slots;
+        const unsigned shift = (slot & 1) * 4;
+        const unsigned count = (counters[slot / 2] >> shift) & 0x0f;
+        if (count > 0 && count < NXFILTER_COUNTER_MAX) {
+            counters[slot / 2] = static_cast<uint8_t>(counters[slot / 2] - (1 << shift));
+        }
+    }
+}
+
+/**
+ * @brief Removes name from both tiers
+ * @param entry entry of exact tier
+ */
+void NegativeFilter::erase(const unordered_map<uint64_t, uint32_t>::iterator entry) {
+    decrement(entry->first);
+    exact.erase(entry);
+}
+
+/**
+ * @brief Checks whether name is known not to exist, expired name is removed
+ * @param name domain name
+ * @return true when name was answered by NXDOMAIN and its negative TTL did not pass yet
+ */
+bool NegativeFilter::contains(const string_view name) {
+    const uint64_t hash = nameHash(name);
+    if (!mayContain(hash)) {
+        return false;
+    }
+    const auto entry = exact.find(hash);
+    if (entry == exact.end()) {
+        stats_count(Counter::NegativeFalsePositives);
+        return false;
+    }
+    if (entry->second <= unix_now()) {
+        erase(entry);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Adds name answered by NXDOMAIN, the first tier is rebuilt twice as large when it is full
+ * @param name domain name
+ * @param ttl negative TTL of response in seconds
+ */
+void NegativeFilter::add(const string_view name, const uint32_t ttl) {
+    if (ttl == 0) {
+        return;
+    }
+    const uint64_t hash = nameHash(name);
+    const uint32_t expires = unix_now() + ttl;
+    const auto [entry, inserted] = exact.emplace(hash, expires);
+    if (!inserted) {
+        entry->second = max(entry->second, expires);
+        return;
+    }
+    if (exact.size() > capacity) {
+        rebuild(capacity * 2);
+    } else {
+        increment(hash);
+    }
+}
+
+/**
+ * @brief Loads names of filter file, expired names are dropped, missing file leaves filter empty
+ * @param path path of filter file
+ * @param error reason why file cannot be used
+ * @return false when file exists but is not filter file
+ */
+bool NegativeFilter::load(const string& path, string& error) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        return true;
+    }
+    char magic[sizeof(NXFILTER_MAGIC)];
+    if (!file.read(magic, sizeof(magic)) || memcmp(magic, NXFILTER_MAGIC, sizeof(magic)) != 0) {
+        error = "File '" + path + "' is not filter of nonexistent names";
+        return false;
+    }
+
+    const uint32_t now = unix_now();
+    exact.clear();
+    WireNegativeEntry entry{};
+    while (file.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+        if (entry.expires > now) {
+            exact.emplace(entry.hash, entry.expires);
+        }
+    }
+    rebuild(exact.size() * 2);
+    return true;
+}
+
+/**
+ * @brief Writes unexpired names to filter file, concurrently running programs see either old or new file (rename is atomic)
+ * @param path path of filter file
+ * @param error reason why file cannot be written
+ * @return true when file was written
+ */
+bool NegativeFilter::save(const string& path, string& error) {
+    const string temporary = path + "." + to_string(getpid());
+    {
+        ofstream file(temporary, ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            error = "Filter file '" + path + "' cannot be written";
+            return false;
+        }
+        file.write(NXFILTER_MAGIC, sizeof(NXFILTER_MAGIC));
+        const uint32_t now = unix_now();
+        for (const auto& [hash, expires] : exact) {
+            if (expires > now) {
+                WireNegativeEntry entry{};
+                entry.hash = hash;
+                entry.expires = expires;
+                file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+            }
+        }
+        // closing flushes the rest of entries, its failure is a write failure too
+        file.close();
+        if (!file.good()) {
+            remove(temporary.c_str());
+            error = "Filter file '" + path + "' cannot be written";
+            return false;
+        }
+    }
+    if (rename(temporary.c_str(), path.c_str()) != 0) {
+        remove(temporary.c_str());
+        error = "Filter file '" + path + "' cannot be replaced";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file nxfilter.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of persistent filter of known nonexistent names (NXDOMAIN), part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef NXFILTER_H
+#define NXFILTER_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// default probability that name not in filter passes its first tier and is checked by exact tier
+constexpr double NXFILTER_FALSE_POSITIVE_RATE = 0.01;
+// counters of the first tier are allocated at least for this many names, filter is rebuilt twice as large when it is full
+constexpr size_t NXFILTER_MIN_CAPACITY = 4096;
+// counters are 4 bits wide, saturated counter is never decremented (its names stay possible members)
+constexpr uint8_t NXFILTER_COUNTER_MAX = 15;
+// start of filter file, the last two characters are version of format
+constexpr char NXFILTER_MAGIC[8] = {'D', 'N', 'S', 'N', 'X', 'F', '0', '1'};
+
+/**
+ * @brief Set of names answered by NXDOMAIN, each kept for negative TTL of its response (RFC 2308).
+ * First tier is counting Bloom filter sized for configured false positive rate, which rejects most names
+ * by a few probes of one compact array. Names it accepts are verified by exact tier (64-bit hash of name
+ * and expiry), so name is never skipped because of false positive of the first tier.
+ * Only exact tier is saved to file, the first tier is rebuilt from it when filter is loaded
+ */
+class NegativeFilter {
+public:
+    explicit NegativeFilter(double false_positive_rate = NXFILTER_FALSE_POSITIVE_RATE);
+
+    bool load(const std::string& path, std::string& error);
+    bool save(const std::string& path, std::string& error);
+
+    bool contains(std::string_view name);
+    void add(std::string_view name, uint32_t ttl);
+
+    size_t size() const {
+        return exact.size();
+    }
+    // bytes of counters of the first tier
+    size_t filterBytes() const {
+        return counters.size();
+    }
+
+private:
+    static uint64_t nameHash(std::string_view name);
+
+    void rebuild(size_t new_capacity);
+    bool mayContain(uint64_t hash) const;
+    void increment(uint64_t hash);
+    void decrement(uint64_t hash);
+    void erase(std::unordered_map<uint64_t, uint32_t>::iterator entry);
+
+    double false_positive_rate;
+    size_t capacity = 0;
+    // number of counters and probes of each name
+    size_t slots = 0;
+    unsigned probes = 0;
+    // two 4-bit counters per byte
+    std::vector<uint8_t> counters;
+    // expiry of each name in seconds since Unix epoch, by hash of name
+    std::unordered_map<uint64_t, uint32_t> exact;
+};
+
+#endif // NXFILTER_H
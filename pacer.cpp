@@ -0,0 +1,117 @@
+/**
+ * @file pacer.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of send pacing (token bucket and in-flight limit with backpressure), part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "pacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "stats.h"
+
+using namespace std;
+
+/**
+ * @brief Sets configured rate and in-flight limit, current values start at configured ones with full bucket
+ * @param qps maximum queries per second, 0 is unlimited
+ * @param max_in_flight maximum queries in flight (window of resolver)
+ */
+void SendPacer::configure(const double qps, const size_t max_in_flight) {
+    max_rate = max(0.0, qps);
+    rate = max_rate;
+    burst = max(1.0, max_rate * PACING_BURST_MS / 1000);
+    tokens = burst;
+    updated = Clock::now();
+    max_limit = static_cast<double>(max<size_t>(1, max_in_flight));
+    limit = max_limit;
+    signals = 0;
+    backoff = Clock::time_point();
+}
+
+/**
+ * @brief Tokens in bucket at given time, bucket is refilled by current rate up to burst
+ * @param now current time
+ * @return number of tokens, negative while debt of retransmissions is paid
+ */
+double SendPacer::tokensAt(const Clock::time_point now) const {
+    const double elapsed = chrono::duration<double>(now - updated).count();
+    return min(burst, tokens + max(0.0, elapsed) * rate);
+}
+
+/**
+ * @brief Checks whether new query can be sent now
+ * @param in_flight queries in flight
+ * @param now current time
+ * @return true when query is below in-flight limit and there is a token
+ */
+bool SendPacer::ready(const size_t in_flight, const Clock::time_point now) const {
+    if (static_cast<double>(in_flight) >= floor(limit)) {
+        return false;
+    }
+    return max_rate == 0 || tokensAt(now) >= 1;
+}
+
+/**
+ * @brief Time until the next token
+ * @param now current time
+ * @return timeout in milliseconds for poll, -1 when token is available (or rate is unlimited)
+ */
+int SendPacer::delay(const Clock::time_point now) const {
+    const double missing = 1 - tokensAt(now);
+    if (max_rate == 0 || missing <= 0) {
+        return -1;
+    }
+    return static_cast<int>(ceil(missing / rate * 1000));
+}
+
+/**
+ * @brief Takes token for sent query, retransmission takes token even when there is none,
+ * so new queries wait until the debt is paid
+ * @param now current time
+ */
+void SendPacer::consume(const Clock::time_point now) {
+    if (max_rate == 0) {
+        return;
+    }
+    tokens = tokensAt(now) - 1;
+    updated = now;
+}
+
+/**
+ * @brief Loss or REFUSED response, when share of these signals exceeds PACING_SIGNAL_THRESHOLD
+ * in-flight limit and rate are halved (once per PACING_BACKOFF_MS, so signals of queries sent
+ * before the backoff took effect do not halve them again)
+ * @param now current time
+ */
+void SendPacer::congestion(const Clock::time_point now) {
+    signals += (1 - signals) / PACING_SIGNAL_WINDOW;
+    if (signals < PACING_SIGNAL_THRESHOLD || now < backoff) {
+        return;
+    }
+    backoff = now + chrono::milliseconds(PACING_BACKOFF_MS);
+    stats_count(Counter::Backoffs);
+    limit = max(1.0, floor(limit / 2));
+    if (max_rate > 0) {
+        tokens = tokensAt(now);
+        updated = now;
+        rate = max(max_rate * PACING_MIN_RATE, rate / 2);
+    }
+}
+
+/**
+ * @brief Clean response, raises in-flight limit by one per limit responses (one per round trip) and rate by a step
+ */
+void SendPacer::success() {
+    signals -= signals / PACING_SIGNAL_WINDOW;
+    limit = min(max_limit, limit + 1 / limit);
+    if (max_rate > 0 && rate < max_rate) {
+        const Clock::time_point now = Clock::now();
+        tokens = tokensAt(now);
+        updated = now;
+        rate = min(max_rate, rate + max_rate * PACING_RATE_STEP);
+    }
+}
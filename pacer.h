@@ -0,0 +1,86 @@
+/**
+ * @file pacer.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of send pacing (token bucket and in-flight limit with backpressure), part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef PACER_H
+#define PACER_H
+
+#include <chrono>
+#include <cstddef>
+
+// burst of token bucket, sends allowed at once after idle period (in milliseconds of rate, at least one send)
+constexpr int PACING_BURST_MS = 10;
+// share of congestion signals (loss or REFUSED) in recent responses that halves in-flight limit and rate,
+// average is exponential over about PACING_SIGNAL_WINDOW responses, isolated loss does not slow down sending
+constexpr double PACING_SIGNAL_THRESHOLD = 0.05;
+constexpr double PACING_SIGNAL_WINDOW = 32;
+// limit and rate are halved at most once per this period
+constexpr int PACING_BACKOFF_MS = 1000;
+// clean response raises rate by this fraction of configured rate (full rate is regained after 1/x responses)
+constexpr double PACING_RATE_STEP = 0.002;
+// rate is never lowered below this fraction of configured rate
+constexpr double PACING_MIN_RATE = 1.0 / 64;
+
+/**
+ * @brief Pacing of queries sent to one upstream server
+ */
+struct PacingConfig {
+    // maximum queries per second, 0 is unlimited
+    double qps = 0;
+    // maximum queries in flight to the server (starting in-flight limit), 0 is the whole window of resolver
+    size_t max_in_flight = 0;
+    // size of socket receive and send buffers in bytes, 0 keeps system default
+    int socket_buffer = 0;
+};
+
+/**
+ * @brief Scheduler between queue of questions and send path. New query can be sent when token bucket has a token
+ * and queries in flight are below limit. Rising share of loss and REFUSED responses halves the limit and the rate (multiplicative decrease),
+ * clean responses raise them back step by step (additive increase), so sending settles just below what upstream accepts
+ */
+class SendPacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void configure(double qps, size_t max_in_flight);
+
+    bool ready(size_t in_flight, Clock::time_point now) const;
+    int delay(Clock::time_point now) const;
+    void consume(Clock::time_point now);
+
+    void congestion(Clock::time_point now);
+    void success();
+
+    double getRate() const {
+        return rate;
+    }
+    // share of congestion signals in recent responses
+    double getSignalRate() const {
+        return signals;
+    }
+    size_t getLimit() const {
+        return static_cast<size_t>(limit);
+    }
+
+private:
+    double tokensAt(Clock::time_point now) const;
+
+    // configured and current rate, 0 when rate is unlimited
+    double max_rate = 0;
+    double rate = 0;
+    double burst = 1;
+    // tokens at time of last update, negative after retransmissions sent without token
+    double tokens = 1;
+    Clock::time_point updated;
+    // configured and current in-flight limit (fractional part grows by additive increase)
+    double max_limit = 1;
+    double limit = 1;
+    double signals = 0;
+    Clock::time_point backoff;
+};
+
+#endif // PACER_H
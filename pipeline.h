@@ -0,0 +1,159 @@
+/**
+ * @file pipeline.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of lock-free single-producer single-consumer ring connecting stages of bulk pipeline, part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "stats.h"
+
+// slots of each queue between stages (power of two), producer waits when its queue is full
+constexpr size_t PIPELINE_QUEUE_SIZE = 1024;
+// I/O stage never waits for full queue, items it keeps aside are offered again at least this often
+constexpr int PIPELINE_RETRY_MS = 1;
+
+/**
+ * @brief Bounded queue between two threads, one pushes and the other pops. Items are filled and consumed in place,
+ * so their buffers (packets, texts) keep capacity and are reused without allocation. Positions of producer and
+ * consumer are on separate cache lines and each side keeps a cached copy of the other position, so shared lines
+ * are touched only when the cached copy says the queue is full or empty. Stage waiting on full or empty queue
+ * blocks (atomic wait) instead of spinning, producer that must not wait uses tryPush. Depth after each push and waits are recorded to statistics
+ */
+template <class T>
+class SpscRing {
+public:
+    /**
+     * @brief Creates empty queue
+     * @param capacity number of slots, power of two
+     * @param queue queue of statistics
+     */
+    SpscRing(const size_t capacity, const Queue queue) : slots(capacity), mask(capacity - 1), queue(queue) {}
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /**
+     * @brief Producer fills the next slot and publishes it, waits while queue is full
+     * @param fill called with slot to overwrite
+     */
+    template <class Fill>
+    void push(Fill&& fill) {
+        const size_t position = tail.load(std::memory_order_relaxed) & ~CLOSED;
+        if (full(position)) {
+            stats_queue_wait(queue, true);
+            do {
+                head.wait(cached_head, std::memory_order_acquire);
+            } while (full(position));
+        }
+        fill(slots[position & mask]);
+        publish(position);
+    }
+
+    /**
+     * @brief Producer fills the next slot and publishes it only when queue has free slot, never waits
+     * @param fill called with slot to overwrite
+     * @return false when queue is full and fill was not called
+     */
+    template <class Fill>
+    bool tryPush(Fill&& fill) {
+        const size_t position = tail.load(std::memory_order_relaxed) & ~CLOSED;
+        if (full(position)) {
+            stats_queue_wait(queue, true);
+            return false;
+        }
+        fill(slots[position & mask]);
+        publish(position);
+        return true;
+    }
+
+    /**
+     * @brief Producer marks the end of items, consumer pops the remaining ones and stops
+     */
+    void close() {
+        tail.fetch_or(CLOSED, std::memory_order_release);
+        tail.notify_one();
+    }
+
+    /**
+     * @brief Consumer passes the oldest item to consume and frees its slot, waits while queue is empty
+     * @param consume called with slot of item, the slot is reused after it returns
+     * @return false when queue is empty and closed
+     */
+    template <class Consume>
+    bool pop(Consume&& consume) {
+        const size_t position = head.load(std::memory_order_relaxed);
+        if (position == cached_tail) {
+            size_t state = tail.load(std::memory_order_acquire);
+            if ((state & ~CLOSED) == position && (state & CLOSED) == 0) {
+                stats_queue_wait(queue, false);
+                do {
+                    tail.wait(state, std::memory_order_acquire);
+                    state = tail.load(std::memory_order_acquire);
+                } while (state == position);
+            }
+            if ((state & ~CLOSED) == position) {
+                return false;
+            }
+            cached_tail = state & ~CLOSED;
+        }
+        consume(slots[position & mask]);
+        head.store(position + 1, std::memory_order_release);
+        head.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Consumer checks whether an item is ready, e.g. to flush its output before it would wait
+     * @return true when pop would wait or stop
+     */
+    bool empty() const {
+        return head.load(std::memory_order_relaxed) == (tail.load(std::memory_order_acquire) & ~CLOSED);
+    }
+
+private:
+    /**
+     * @brief Producer checks free slot, head of consumer is read only when cached copy shows full queue
+     * @param position position of the next push
+     * @return true when all slots are taken
+     */
+    bool full(const size_t position) {
+        if (position - cached_head == slots.size()) {
+            cached_head = head.load(std::memory_order_acquire);
+        }
+        return position - cached_head == slots.size();
+    }
+
+    /**
+     * @brief Producer publishes filled slot and wakes waiting consumer
+     * @param position position of the filled slot
+     */
+    void publish(const size_t position) {
+        tail.store(position + 1, std::memory_order_release);
+        tail.notify_one();
+        if (stats_enabled) {
+            stats_queue_depth(queue, position + 1 - head.load(std::memory_order_relaxed));
+        }
+    }
+
+    // highest bit of tail, set by close so waiting consumer wakes up
+    static constexpr size_t CLOSED = size_t{1} << (sizeof(size_t) * 8 - 1);
+
+    std::vector<T> slots;
+    const size_t mask;
+    const Queue queue;
+    // written by producer: number of pushed items (and CLOSED), head as producer last saw it
+    alignas(64) std::atomic<size_t> tail{0};
+    size_t cached_head = 0;
+    // written by consumer: number of popped items, tail as consumer last saw it
+    alignas(64) std::atomic<size_t> head{0};
+    size_t cached_tail = 0;
+};
+
+#endif // PIPELINE_H
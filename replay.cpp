@@ -0,0 +1,265 @@
+/**
+ * @file replay.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of recording of query sessions and their replay by loopback server, part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "replay.h"
+
+#include <chrono>
+#include <cmath>
+#include <queue>
+#include <set>
+
+#include "cache.h"
+
+using namespace std;
+
+/**
+ * @brief Creates session log, existing file is overwritten
+ * @param path path of log
+ * @param error reason why file cannot be created
+ * @return true when log is open
+ */
+bool SessionRecorder::open(const string& path, string& error) {
+    const lock_guard<mutex> lock(file_mutex);
+    file.open(path, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        error = "Session log '" + path + "' cannot be created";
+        return false;
+    }
+    file.write(SESSION_MAGIC, sizeof(SESSION_MAGIC));
+    records = 0;
+    return true;
+}
+
+/**
+ * @brief Appends query with its response to log
+ * @param query query in wire format
+ * @param query_size size of query
+ * @param response response in wire format, nullptr when query was given up
+ * @param response_size size of response
+ * @param latency_ns time from the first transmission to receipt of response (or to giving up)
+ */
+void SessionRecorder::record(const uint8_t* query, const size_t query_size, const uint8_t* response, const size_t response_size,
+                             const uint64_t latency_ns) {
+    if (query_size > 0xffff || response_size > 0xffff) {
+        return;
+    }
+    WireSessionRecord header{};
+    header.latency_us = static_cast<uint32_t>(min<uint64_t>(latency_ns / 1000, UINT32_MAX));
+    header.query_length = static_cast<uint16_t>(query_size);
+    header.response_length = static_cast<uint16_t>(response != nullptr ? response_size : 0);
+
+    const lock_guard<mutex> lock(file_mutex);
+    if (!file.is_open()) {
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(query), static_cast<streamsize>(query_size));
+    if (response != nullptr) {
+        file.write(reinterpret_cast<const char*>(response), static_cast<streamsize>(response_size));
+    }
+    records++;
+}
+
+/**
+ * @brief Reads all records of session log
+ * @param path path of log
+ * @param records read records
+ * @param error reason why log cannot be read
+ * @return false when file cannot be opened, is not session log or is truncated
+ */
+bool load_session(const string& path, vector<SessionRecord>& records, string& error) {
+    ifstream file(path, ios::binary);
+    char magic[sizeof(SESSION_MAGIC)];
+    if (!file.is_open()) {
+        error = "Session log '" + path + "' cannot be opened";
+        return false;
+    }
+    if (!file.read(magic, sizeof(magic)) || memcmp(magic, SESSION_MAGIC, sizeof(magic)) != 0) {
+        error = "File '" + path + "' is not session log";
+        return false;
+    }
+
+    WireSessionRecord header{};
+    while (file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        SessionRecord record;
+        record.latency_us = header.latency_us;
+        record.query.resize(header.query_length);
+        record.response.resize(header.response_length);
+        if (!file.read(reinterpret_cast<char*>(record.query.data()), static_cast<streamsize>(record.query.size())) ||
+            !file.read(reinterpret_cast<char*>(record.response.data()), static_cast<streamsize>(record.response.size()))) {
+            error = "Session log '" + path + "' is truncated after " + to_string(records.size()) + " records";
+            return false;
+        }
+        records.push_back(move(record));
+    }
+    if (file.gcount() != 0) {
+        error = "Session log '" + path + "' is truncated after " + to_string(records.size()) + " records";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Cache key of question of query in wire format
+ * @param packet query
+ * @param length length of query
+ * @param arena memory of parsed question
+ * @return key, empty when query has no question
+ */
+static string question_key(const uint8_t* packet, const size_t length, Arena& arena) {
+    if (length < sizeof(WireHeader) || reinterpret_cast<const WireHeader*>(packet)->qdcount != 1) {
+        return "";
+    }
+    arena.reset();
+    WireReader reader(packet, length, sizeof(WireHeader));
+    const DNSQuestion question(reader, &arena);
+    return reader.isValid() ? AnswerCache::key(question) : "";
+}
+
+/**
+ * @brief Binds server to ephemeral port of loopback and starts serving recorded responses
+ * @param records recorded session
+ * @param speed factor of recorded latencies (0 answers immediately, 2 doubles latency)
+ * @param error reason why server cannot be started
+ * @return true when server is running
+ */
+bool ReplayServer::start(vector<SessionRecord> records, const double speed, string& error) {
+    stop();
+    session = move(records);
+    this->speed = max(0.0, speed);
+    questions.clear();
+    Arena arena;
+    for (const auto& record : session) {
+        const string key = question_key(record.query.data(), record.query.size(), arena);
+        if (!key.empty()) {
+            questions[key].records.push_back(&record);
+        }
+    }
+
+    server_fd = static_cast<int>(socket(AF_INET, SOCK_DGRAM, 0));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_length = sizeof(address);
+    if (server_fd == -1 || bind(server_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == -1 ||
+        getsockname(server_fd, reinterpret_cast<sockaddr*>(&address), &address_length) == -1) {
+        error = "Replay server cannot be bound to loopback";
+        stop();
+        return false;
+    }
+    port = ntohs(address.sin_port);
+    running = true;
+    worker = thread(&ReplayServer::run, this);
+    return true;
+}
+
+/**
+ * @brief Stops serving thread and closes server socket
+ */
+void ReplayServer::stop() {
+    running = false;
+    if (worker.joinable()) {
+        worker.join();
+    }
+    if (server_fd != -1) {
+        close(server_fd);
+        server_fd = -1;
+    }
+}
+
+/**
+ * @brief Serving loop: each query is matched by its question to recorded response, which is sent with ID of the query
+ * after recorded latency. Retransmission of query waiting for its response is ignored, query that was given up
+ * in recorded session gets no response, query that was not recorded gets SERVFAIL at once
+ */
+void ReplayServer::run() {
+    /**
+     * @brief Response waiting for its time
+     */
+    struct Scheduled {
+        chrono::steady_clock::time_point due;
+        vector<uint8_t> packet;
+        sockaddr_storage client{};
+        socklen_t client_length = 0;
+
+        bool operator>(const Scheduled& other) const {
+            return due > other.due;
+        }
+    };
+    priority_queue<Scheduled, vector<Scheduled>, greater<>> scheduled;
+    // (client address, ID) of scheduled responses
+    set<pair<string, uint16_t>> waiting;
+    Arena arena;
+    uint8_t packet[BUFFER_SIZE];
+
+    while (running) {
+        int timeout = REPLAY_POLL_MS;
+        if (!scheduled.empty()) {
+            const auto remaining = chrono::duration_cast<chrono::microseconds>(scheduled.top().due - chrono::steady_clock::now()).count();
+            timeout = static_cast<int>(min<int64_t>(timeout, max<int64_t>(0, (remaining + 999) / 1000)));
+        }
+        pollfd fds{};
+        fds.fd = server_fd;
+        fds.events = POLLIN;
+        if (poll(&fds, 1, timeout) > 0) {
+            Scheduled response;
+            response.client_length = sizeof(response.client);
+            ssize_t length;
+            while ((length = recvfrom(server_fd, reinterpret_cast<char*>(packet), sizeof(packet), MSG_DONTWAIT,
+                                      reinterpret_cast<sockaddr*>(&response.client), &response.client_length)) >= 0) {
+                const size_t query_length = static_cast<size_t>(length);
+                const string key = question_key(packet, query_length, arena);
+                if (key.empty()) {
+                    response.client_length = sizeof(response.client);
+                    continue;
+                }
+                const uint16_t id = reinterpret_cast<const WireHeader*>(packet)->id;
+                const string client(reinterpret_cast<const char*>(&response.client), response.client_length);
+                if (waiting.count({client, id}) > 0) {
+                    response.client_length = sizeof(response.client);
+                    continue;
+                }
+
+                const auto recorded = questions.find(key);
+                if (recorded == questions.end()) {
+                    // not recorded, server failure with question of query
+                    unmatched++;
+                    auto* header = reinterpret_cast<WireHeader*>(packet);
+                    header->flags = static_cast<uint16_t>((header->flags & 0x7900) | 0x8082);
+                    header->ancount = 0;
+                    header->nscount = 0;
+                    header->arcount = 0;
+                    sendto(server_fd, reinterpret_cast<const char*>(packet), query_length, 0,
+                           reinterpret_cast<const sockaddr*>(&response.client), response.client_length);
+                    response.client_length = sizeof(response.client);
+                    continue;
+                }
+                const SessionRecord& record = *recorded->second.records[recorded->second.next++ % recorded->second.records.size()];
+                if (record.response.size() >= sizeof(WireHeader)) {
+                    response.packet = record.response;
+                    reinterpret_cast<WireHeader*>(response.packet.data())->id = id;
+                    response.due = chrono::steady_clock::now() +
+                                   chrono::microseconds(static_cast<int64_t>(llround(record.latency_us * speed)));
+                    waiting.insert({client, id});
+                    scheduled.push(response);
+                }
+                response.client_length = sizeof(response.client);
+            }
+        }
+
+        const auto now = chrono::steady_clock::now();
+        while (!scheduled.empty() && scheduled.top().due <= now) {
+            const Scheduled& response = scheduled.top();
+            sendto(server_fd, reinterpret_cast<const char*>(response.packet.data()), response.packet.size(), 0,
+                   reinterpret_cast<const sockaddr*>(&response.client), response.client_length);
+            waiting.erase({string(reinterpret_cast<const char*>(&response.client), response.client_length),
+                           reinterpret_cast<const WireHeader*>(response.packet.data())->id});
+            scheduled.pop();
+        }
+    }
+}
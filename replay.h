@@ -0,0 +1,113 @@
+/**
+ * @file replay.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of recording of query sessions and their replay by loopback server, part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "dns.h"
+
+// start of session log, the last two characters are version of format
+constexpr char SESSION_MAGIC[8] = {'D', 'N', 'S', 'R', 'E', 'C', '0', '1'};
+// replay server checks whether it was stopped at least this often
+constexpr int REPLAY_POLL_MS = 100;
+
+/**
+ * @brief Header of record in session log, followed by query and response in wire format
+ */
+struct WireSessionRecord {
+    // time from the first transmission of query to receipt of response (or to giving it up) in microseconds
+    BigEndian<uint32_t> latency_us;
+    BigEndian<uint16_t> query_length;
+    // 0 when query was given up without response
+    BigEndian<uint16_t> response_length;
+};
+
+/**
+ * @brief Query and response of recorded session
+ */
+struct SessionRecord {
+    vector<uint8_t> query;
+    vector<uint8_t> response;
+    uint32_t latency_us = 0;
+};
+
+/**
+ * @brief Writer of session log, resolvers pass it every query with its response and observed latency.
+ * One recorder can be shared by resolvers running in different threads
+ */
+class SessionRecorder {
+public:
+    bool open(const string& path, string& error);
+    void record(const uint8_t* query, size_t query_size, const uint8_t* response, size_t response_size, uint64_t latency_ns);
+
+    bool isOpen() const {
+        return file.is_open();
+    }
+    size_t getRecords() const {
+        return records;
+    }
+
+private:
+    ofstream file;
+    mutex file_mutex;
+    size_t records = 0;
+};
+
+bool load_session(const string& path, vector<SessionRecord>& records, string& error);
+
+/**
+ * @brief UDP server on loopback answering queries by recorded responses after recorded latency (multiplied by speed factor),
+ * so benchmarks run against realistic traffic without network. Server runs in its own thread until it is stopped
+ */
+class ReplayServer {
+public:
+    ReplayServer() = default;
+    ~ReplayServer() {
+        stop();
+    }
+    ReplayServer(const ReplayServer&) = delete;
+    ReplayServer& operator=(const ReplayServer&) = delete;
+
+    bool start(vector<SessionRecord> records, double speed, string& error);
+    void stop();
+
+    uint16_t getPort() const {
+        return port;
+    }
+    // queries without recorded response, answered by SERVFAIL
+    uint64_t getUnmatched() const {
+        return unmatched.load(std::memory_order_relaxed);
+    }
+
+private:
+    /**
+     * @brief Recorded responses of one question, repeated question gets them in recorded order
+     */
+    struct Recorded {
+        vector<const SessionRecord*> records;
+        size_t next = 0;
+    };
+
+    void run();
+
+    vector<SessionRecord> session;
+    unordered_map<string, Recorded> questions;
+    double speed = 1;
+    int server_fd = -1;
+    uint16_t port = 0;
+    thread worker;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> unmatched{0};
+};
+
+#endif // REPLAY_H
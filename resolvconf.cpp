@@ -0,0 +1,542 @@
+/**
+ * @file resolvconf.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of system resolver configuration and server address lookup cached between runs, part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "resolvconf.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/**
+ * @brief Splits line into whitespace separated words
+ * @param line line of configuration
+ * @return words of line
+ */
+static vector<string_view> split_words(const string_view line) {
+    vector<string_view> words;
+    size_t start = 0;
+    while (start < line.length()) {
+        while (start < line.length() && (line[start] == ' ' || line[start] == '\t' || line[start] == '\r')) {
+            start++;
+        }
+        size_t end = start;
+        while (end < line.length() && line[end] != ' ' && line[end] != '\t' && line[end] != '\r') {
+            end++;
+        }
+        if (end > start) {
+            words.push_back(line.substr(start, end - start));
+        }
+        start = end;
+    }
+    return words;
+}
+
+/**
+ * @brief Reads whole file by one open and read, without stream machinery (files read at startup are small)
+ * @param path path of the file
+ * @param text output content of the file
+ * @return true if file was read
+ */
+static bool read_file(const string& path, string& text) {
+    text.clear();
+#if defined(_WIN32) || defined(_WIN64)
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    ostringstream content;
+    content << file.rdbuf();
+    text = content.str();
+    return true;
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    char buffer[4096];
+    ssize_t length;
+    while ((length = ::read(fd, buffer, sizeof(buffer))) > 0) {
+        text.append(buffer, static_cast<size_t>(length));
+    }
+    ::close(fd);
+    return length == 0;
+#endif
+}
+
+/**
+ * @brief Parses numeric value of option (e.g. "ndots:2"), value is limited to range (0 - maximum)
+ * @param word option with value
+ * @param name name of option with colon
+ * @param maximum largest allowed value
+ * @param value output value, unchanged when option does not match
+ */
+static void parse_option(const string_view word, const string_view name, const int maximum, int& value) {
+    if (word.substr(0, name.length()) != name) {
+        return;
+    }
+    int number = 0;
+    for (const char c : word.substr(name.length())) {
+        if (c < '0' || c > '9') {
+            return;
+        }
+        number = min(number * 10 + (c - '0'), maximum);
+    }
+    value = number;
+}
+
+/**
+ * @brief Parses content of resolv.conf: nameserver, search, domain and options (ndots, timeout, attempts, rotate),
+ * unknown keywords are ignored like in resolv.conf(5)
+ * @param text content of the file
+ */
+void ResolverConfig::parse(const string& text) {
+    size_t start = 0;
+    while (start < text.length()) {
+        size_t end = text.find('\n', start);
+        if (end == string::npos) {
+            end = text.length();
+        }
+        const string_view line = string_view(text).substr(start, end - start);
+        start = end + 1;
+        if (line.empty() || line[0] == '#' || line[0] == ';') {
+            continue;
+        }
+
+        const vector<string_view> words = split_words(line);
+        if (words.size() < 2) {
+            continue;
+        }
+        if (words[0] == "nameserver") {
+            if (nameservers.size() < RESOLV_MAX_NAMESERVERS) {
+                nameservers.emplace_back(words[1]);
+            }
+        } else if (words[0] == "search" || words[0] == "domain") {
+            // the last search or domain line wins
+            search.clear();
+            for (size_t i = 1; i < words.size() && search.size() < RESOLV_MAX_SEARCH; i++) {
+                if (words[i][0] == '#' || words[i][0] == ';') {
+                    break;
+                }
+                string domain(words[i]);
+                while (!domain.empty() && domain.back() == '.') {
+                    domain.pop_back();
+                }
+                if (!domain.empty()) {
+                    search.push_back(move(domain));
+                }
+                if (words[0] == "domain") {
+                    break;
+                }
+            }
+        } else if (words[0] == "options") {
+            for (size_t i = 1; i < words.size(); i++) {
+                parse_option(words[i], "ndots:", RESOLV_MAX_NDOTS, ndots);
+                parse_option(words[i], "timeout:", RESOLV_MAX_TIMEOUT, timeout);
+                parse_option(words[i], "attempts:", RESOLV_MAX_ATTEMPTS, attempts);
+                if (words[i] == "rotate") {
+                    rotate = true;
+                }
+            }
+        }
+    }
+    timeout = max(timeout, 1);
+    attempts = max(attempts, 1);
+}
+
+/**
+ * @brief Reads and parses resolv.conf file
+ * @param path path of the file
+ * @return true if file was read
+ */
+bool ResolverConfig::parseFile(const string& path) {
+    string text;
+    if (!read_file(path, text)) {
+        return false;
+    }
+    parse(text);
+    source = path;
+    return true;
+}
+
+/**
+ * @brief Expands name by search list (resolv.conf semantics): name with at least ndots dots is tried as typed
+ * first, shorter name after all search domains, name ending with dot is never expanded
+ * @param name name as typed
+ * @return candidate names in order of priority
+ */
+vector<string> ResolverConfig::candidates(const string& name) const {
+    if (search.empty() || name.empty() || name.back() == '.') {
+        return {name};
+    }
+    const auto dots = count(name.begin(), name.end(), '.');
+    vector<string> names;
+    names.reserve(search.size() + 1);
+    if (dots >= ndots) {
+        names.push_back(name);
+    }
+    for (const auto& domain : search) {
+        names.push_back(name + "." + domain);
+    }
+    if (dots < ndots) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+/**
+ * @brief Addresses of server given by hostname
+ */
+struct HostEntry {
+    string host;
+    uint16_t port = 0;
+    int64_t expires = 0;
+    vector<ServerAddress> addresses;
+};
+
+/**
+ * @brief Content of cache file shared by all runs of the program, only hostname lookups are kept
+ * (parsing resolv.conf is cheaper than reading any cache of it)
+ */
+struct ResolverCache {
+    string path;
+    bool loaded = false;
+    vector<HostEntry> hosts;
+};
+
+static mutex cache_mutex;
+static ResolverCache cache;
+
+/**
+ * @brief Current wall clock time, cache entries outlive the process
+ * @return seconds since epoch
+ */
+static int64_t unix_now() {
+    return chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Encodes bytes as hexadecimal string
+ * @param data bytes to encode
+ * @param length number of bytes
+ * @return hexadecimal string
+ */
+static string to_hex(const uint8_t* data, const size_t length) {
+    static const char digits[] = "0123456789abcdef";
+    string hex;
+    hex.reserve(2 * length);
+    for (size_t i = 0; i < length; i++) {
+        hex += digits[data[i] >> 4];
+        hex += digits[data[i] & 0x0f];
+    }
+    return hex;
+}
+
+/**
+ * @brief Decodes hexadecimal string of socket address
+ * @param hex hexadecimal string
+ * @param address output address
+ * @return true if string is valid address
+ */
+static bool from_hex(const string_view hex, ServerAddress& address) {
+    if (hex.length() % 2 != 0 || hex.length() / 2 > sizeof(address.address)) {
+        return false;
+    }
+    auto nibble = [](const char c) {
+        return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+    };
+    auto* bytes = reinterpret_cast<uint8_t*>(&address.address);
+    for (size_t i = 0; i < hex.length(); i += 2) {
+        const int high = nibble(hex[i]);
+        const int low = nibble(hex[i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        bytes[i / 2] = static_cast<uint8_t>(high << 4 | low);
+    }
+    address.length = static_cast<socklen_t>(hex.length() / 2);
+    const int family = reinterpret_cast<const sockaddr*>(bytes)->sa_family;
+    return family == AF_INET || family == AF_INET6;
+}
+
+/**
+ * @brief Parses decimal number of cache file
+ * @param word the number
+ * @param value output number
+ * @return true if word is number fitting into value
+ */
+template<class T>
+static bool parse_number(const string_view word, T& value) {
+    const auto [end, status] = from_chars(word.data(), word.data() + word.length(), value);
+    return status == errc() && end == word.data() + word.length();
+}
+
+/**
+ * @brief Reads cache file once, malformed lines are skipped
+ */
+static void cache_load() {
+    if (cache.loaded || cache.path.empty()) {
+        return;
+    }
+    cache.loaded = true;
+    string text;
+    if (!read_file(cache.path, text) || text.compare(0, 12, "dns-cache 2\n") != 0) {
+        return;
+    }
+
+    size_t start = 12;
+    while (start < text.length()) {
+        size_t end = text.find('\n', start);
+        if (end == string::npos) {
+            end = text.length();
+        }
+        const vector<string_view> words = split_words(string_view(text).substr(start, end - start));
+        start = end + 1;
+        // host EXPIRES PORT ADDRESS HOST
+        HostEntry entry;
+        ServerAddress address;
+        if (words.size() != 5 || words[0] != "host" || !parse_number(words[1], entry.expires) ||
+            !parse_number(words[2], entry.port) || !from_hex(words[3], address)) {
+            continue;
+        }
+        if (cache.hosts.empty() || cache.hosts.back().host != words[4] || cache.hosts.back().port != entry.port) {
+            entry.host = words[4];
+            cache.hosts.push_back(move(entry));
+        }
+        cache.hosts.back().addresses.push_back(address);
+    }
+}
+
+/**
+ * @brief Writes cache file, concurrently running programs see either old or new file (rename is atomic),
+ * missing directory of the file is created
+ */
+static void cache_save() {
+    if (cache.path.empty()) {
+        return;
+    }
+#if !defined(_WIN32) && !defined(_WIN64)
+    if (const size_t slash = cache.path.rfind('/'); slash != string::npos && slash > 0) {
+        mkdir(cache.path.substr(0, slash).c_str(), 0700);
+    }
+#endif
+    const string temporary = cache.path + "." + to_string(getpid());
+    {
+        ofstream file(temporary, ios::trunc);
+        if (!file.is_open()) {
+            return;
+        }
+        file << "dns-cache 2\n";
+        for (const auto& entry : cache.hosts) {
+            for (const auto& address : entry.addresses) {
+                file << "host " << entry.expires << ' ' << entry.port << ' '
+                     << to_hex(reinterpret_cast<const uint8_t*>(&address.address), address.length) << ' ' << entry.host << '\n';
+            }
+        }
+        if (!file.good()) {
+            file.close();
+            remove(temporary.c_str());
+            return;
+        }
+    }
+    if (rename(temporary.c_str(), cache.path.c_str()) != 0) {
+        remove(temporary.c_str());
+    }
+}
+
+/**
+ * @brief Default path of cache file: $XDG_CACHE_HOME/dns-resolver.cache or ~/.cache/dns-resolver.cache,
+ * nothing is created until the cache is saved
+ * @return path of cache file, empty when home directory is unknown
+ */
+string resolver_cache_default_path() {
+    if (const char* cache_home = getenv("XDG_CACHE_HOME"); cache_home != nullptr && cache_home[0] != '\0') {
+        return string(cache_home) + "/dns-resolver.cache";
+    }
+    if (const char* home = getenv("HOME"); home != nullptr && home[0] != '\0') {
+        return string(home) + "/.cache/dns-resolver.cache";
+    }
+    return "";
+}
+
+/**
+ * @brief Enables cache file of server addresses, the file is read by the first lookup of hostname,
+ * without it nothing is kept between runs
+ * @param path path of cache file, empty disables cache
+ */
+void resolver_cache_open(const string& path) {
+    const lock_guard<mutex> lock(cache_mutex);
+    cache = ResolverCache();
+    cache.path = path;
+}
+
+/**
+ * @brief Checks whether server is given by IP address, such server needs no lookup and no cache
+ * @param host IP address or hostname of server
+ * @return true for IPv4 or IPv6 address
+ */
+bool server_address_literal(const string& host) {
+    in6_addr address{};
+    return inet_pton(AF_INET, host.c_str(), &address) == 1 || inet_pton(AF_INET6, host.c_str(), &address) == 1;
+}
+
+
+/**
+ * @brief Loads system resolver configuration: /etc/resolv.conf, nameservers of systemd-resolved when it has none.
+ * Files are parsed on every call, it costs less than checking and reading a cached copy
+ * @param config output configuration
+ * @return true if at least one nameserver was found
+ */
+bool resolver_config_load(ResolverConfig& config) {
+    config = ResolverConfig();
+#if defined(_WIN32) || defined(_WIN64) // windows
+    ULONG flags = GAA_FLAG_INCLUDE_ALL_INTERFACES;
+    ULONG family = AF_UNSPEC;  // Get both IPv4 and IPv6 addresses
+    ULONG outBufLen = 0;
+    PIP_ADAPTER_ADDRESSES pAddresses = nullptr, pCurrAdapter = nullptr;
+
+    if (GetAdaptersAddresses(family, flags, nullptr, pAddresses, &outBufLen) == ERROR_BUFFER_OVERFLOW) {
+        pAddresses = (PIP_ADAPTER_ADDRESSES)malloc(outBufLen);
+    }
+
+    if (pAddresses == nullptr) {
+        return false; // memory allocation failed, server has to be specified manually
+    }
+
+    if (GetAdaptersAddresses(family, flags, nullptr, pAddresses, &outBufLen) == NO_ERROR) {
+        for (pCurrAdapter = pAddresses; pCurrAdapter; pCurrAdapter = pCurrAdapter->Next) {
+            if (pCurrAdapter->OperStatus != IfOperStatusUp) {
+                continue;
+            }
+            for (PIP_ADAPTER_DNS_SERVER_ADDRESS pDns = pCurrAdapter->FirstDnsServerAddress; pDns; pDns = pDns->Next) {
+                SOCKADDR* addr = pDns->Address.lpSockaddr;
+                char dnsStr[INET6_ADDRSTRLEN] = "";
+
+                if (addr->sa_family == AF_INET) {
+                    inet_ntop(AF_INET, &((struct sockaddr_in*)addr)->sin_addr, dnsStr, sizeof(dnsStr));
+                } else if (addr->sa_family == AF_INET6) {
+                    inet_ntop(AF_INET6, &((struct sockaddr_in6*)addr)->sin6_addr, dnsStr, sizeof(dnsStr));
+                }
+
+                if (strlen(dnsStr) > 0 && config.nameservers.size() < RESOLV_MAX_NAMESERVERS) {
+                    config.nameservers.emplace_back(dnsStr);
+                }
+            }
+        }
+    }
+
+    free(pAddresses);
+    return !config.nameservers.empty();
+
+#else // unix
+    const string paths[] = {RESOLV_CONF_PATH, RESOLVED_CONF_PATH, RESOLVED_STUB_CONF_PATH};
+
+    // options and search list come from /etc/resolv.conf, only missing nameservers are taken from systemd-resolved
+    config.parseFile(RESOLV_CONF_PATH);
+    for (size_t i = 1; i < size(paths) && config.nameservers.empty(); i++) {
+        ResolverConfig resolved;
+        if (resolved.parseFile(paths[i]) && !resolved.nameservers.empty()) {
+            config.nameservers = resolved.nameservers;
+            config.source = paths[i];
+            if (config.search.empty()) {
+                config.search = resolved.search;
+            }
+        }
+    }
+
+    return !config.nameservers.empty();
+#endif // _WIN32 || _WIN64
+}
+
+/**
+ * @brief Copies IPv4 and IPv6 addresses from getaddrinfo result
+ * @param result result of getaddrinfo
+ * @param addresses output addresses
+ */
+static void copy_addresses(const addrinfo* result, vector<ServerAddress>& addresses) {
+    for (const addrinfo* ai = result; ai != nullptr; ai = ai->ai_next) {
+        if ((ai->ai_family != AF_INET && ai->ai_family != AF_INET6) || ai->ai_addrlen > sizeof(sockaddr_storage)) {
+            continue;
+        }
+        ServerAddress address;
+        memcpy(&address.address, ai->ai_addr, ai->ai_addrlen);
+        address.length = static_cast<socklen_t>(ai->ai_addrlen);
+        addresses.push_back(address);
+    }
+}
+
+/**
+ * @brief Resolves address of server, addresses of hostname are reused from cache file for SERVER_CACHE_TTL_SEC
+ * @param host IP address or hostname of server
+ * @param port port of server
+ * @param addresses output addresses
+ * @param error reason of failure
+ * @return true if at least one address was found
+ */
+bool server_address_lookup(const string& host, const uint16_t port, vector<ServerAddress>& addresses, string& error) {
+    addresses.clear();
+    addrinfo hints{}, *result;
+    hints.ai_family = AF_UNSPEC; // Allow IPv4 or IPv6
+    hints.ai_socktype = SOCK_DGRAM; // Datagram socket
+    const string service = to_string(port);
+
+    // IP address is converted without lookup, there is nothing to cache
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    if (getaddrinfo(host.c_str(), service.c_str(), &hints, &result) == 0) {
+        copy_addresses(result, addresses);
+        freeaddrinfo(result);
+        return !addresses.empty();
+    }
+
+    const lock_guard<mutex> lock(cache_mutex);
+    cache_load();
+    const int64_t now = unix_now();
+    for (const auto& entry : cache.hosts) {
+        if (entry.host == host && entry.port == port && entry.expires > now) {
+            addresses = entry.addresses;
+            return true;
+        }
+    }
+
+    hints.ai_flags = AI_NUMERICSERV;
+    int status;
+    if ((status = getaddrinfo(host.c_str(), service.c_str(), &hints, &result)) != 0) {
+        error = gai_strerror(status);
+        return false;
+    }
+    copy_addresses(result, addresses);
+    freeaddrinfo(result);
+    if (addresses.empty()) {
+        error = "no IPv4 or IPv6 address";
+        return false;
+    }
+
+    if (!cache.path.empty() && host.find_first_of(" \t\n") == string::npos) {
+        vector<HostEntry> hosts;
+        for (auto& entry : cache.hosts) {
+            if (entry.expires > now && !(entry.host == host && entry.port == port)) {
+                hosts.push_back(move(entry));
+            }
+        }
+        hosts.push_back({host, port, now + SERVER_CACHE_TTL_SEC, addresses});
+        cache.hosts = move(hosts);
+        cache_save();
+    }
+    return true;
+}
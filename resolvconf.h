@@ -0,0 +1,59 @@
+/**
+ * @file resolvconf.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of system resolver configuration and server address lookup cached between runs, part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef RESOLVCONF_H
+#define RESOLVCONF_H
+
+#include "dns.h"
+
+constexpr const char* RESOLV_CONF_PATH = "/etc/resolv.conf";
+// written by systemd-resolved, the first one lists upstream servers, the second one its local stub
+constexpr const char* RESOLVED_CONF_PATH = "/run/systemd/resolve/resolv.conf";
+constexpr const char* RESOLVED_STUB_CONF_PATH = "/run/systemd/resolve/stub-resolv.conf";
+// limits of resolv.conf(5)
+constexpr size_t RESOLV_MAX_NAMESERVERS = 3;
+constexpr size_t RESOLV_MAX_SEARCH = 6;
+constexpr int RESOLV_MAX_NDOTS = 15;
+constexpr int RESOLV_MAX_TIMEOUT = 30;
+constexpr int RESOLV_MAX_ATTEMPTS = 5;
+// addresses of server given by hostname are reused from cache file for this long
+constexpr int64_t SERVER_CACHE_TTL_SEC = 300;
+
+/**
+ * @brief Resolver configuration of system (resolv.conf options relevant for stub resolver)
+ */
+struct ResolverConfig {
+    vector<string> nameservers;
+    vector<string> search;
+    int ndots = 1;
+    int timeout = 5;
+    int attempts = 2;
+    bool rotate = false;
+    // file the configuration was read from
+    string source;
+
+    void parse(const string& text);
+    bool parseFile(const string& path);
+    vector<string> candidates(const string& name) const;
+};
+
+/**
+ * @brief Socket address of server
+ */
+struct ServerAddress {
+    sockaddr_storage address{};
+    socklen_t length = 0;
+};
+
+string resolver_cache_default_path();
+void resolver_cache_open(const string& path);
+bool server_address_literal(const string& host);
+bool resolver_config_load(ResolverConfig& config);
+bool server_address_lookup(const string& host, uint16_t port, vector<ServerAddress>& addresses, string& error);
+
+#endif // RESOLVCONF_H
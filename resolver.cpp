@@ -0,0 +1,847 @@
+/**
+ * @file resolver.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of reentrant dns resolver, part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "resolver.h"
+
+#include <cerrno>
+#include <ctime>
+
+#include "stats.h"
+
+using namespace std;
+
+/**
+ * @brief Returns description of resolver status
+ * @param status resolver status
+ * @return description of status
+ */
+const char* resolver_status_string(const ResolverStatus status) {
+    switch (status) {
+        case ResolverStatus::Ok:
+            return "Success";
+        case ResolverStatus::ServerError:
+            return "Server address cannot be resolved";
+        case ResolverStatus::SocketError:
+            return "Socket creation failed";
+        case ResolverStatus::NotOpen:
+            return "Socket not initialized";
+        case ResolverStatus::SendError:
+            return "Packet send failed";
+        case ResolverStatus::ReceiveError:
+            return "Packet receive failed";
+        case ResolverStatus::Timeout:
+            return "Response timeout";
+        case ResolverStatus::ProtocolError:
+            return "Invalid response";
+        case ResolverStatus::Interrupted:
+            return "Interrupted";
+    }
+    return "Unknown error";
+}
+
+/**
+ * @brief Resolve server address (hostname lookups are cached when resolver cache is open) and connect socket to it
+ * @param host IP address or hostname of server
+ * @param port port of server
+ * @return Ok, ServerError (details in getError) or SocketError
+ */
+ResolverStatus Resolver::open(const string& host, const uint16_t port) {
+    StageTimer init_timer(Stage::Init);
+    disconnect();
+
+    vector<ServerAddress> addresses;
+    if (!server_address_lookup(host, port, addresses, error)) {
+        return ResolverStatus::ServerError;
+    }
+    return open(addresses);
+}
+
+/**
+ * @brief Connect socket to the first address of server that accepts it
+ * @param addresses IPv4 or IPv6 addresses of server
+ * @return Ok or SocketError
+ */
+ResolverStatus Resolver::open(const vector<ServerAddress>& addresses) {
+    disconnect();
+
+    for (const auto& address : addresses) {
+        const auto* ai_addr = reinterpret_cast<const sockaddr*>(&address.address);
+        // Address is not IPv4 or IPv6, try the next address
+        if (ai_addr->sa_family != AF_INET && ai_addr->sa_family != AF_INET6) {
+            continue;
+        }
+
+        // Socket creation failed, try the next address
+        if ((socket_fd = socket(ai_addr->sa_family, SOCK_DGRAM, 0)) == -1) {
+            continue;
+        }
+
+        // Connection failed, close the socket and try the next address
+        if (connect(socket_fd, ai_addr, address.length) == -1) {
+            close(socket_fd);
+            socket_fd = -1;
+            continue;
+        }
+
+        // Connected successfully
+        applySocketOptions();
+        return ResolverStatus::Ok;
+    }
+
+    // No address succeeded
+    error = "no address of server can be connected";
+    return ResolverStatus::SocketError;
+}
+
+/**
+ * @brief Sets pacing of bulk mode, rate applies from next openWindow, socket buffers are resized immediately
+ * when socket is open (otherwise when it is opened)
+ * @param config pacing configuration
+ */
+void Resolver::setPacing(const PacingConfig& config) {
+    pacing = config;
+    applySocketOptions();
+}
+
+/**
+ * @brief Enables kernel receive timestamps, round trip times are then measured from the send syscall
+ * to the time packet arrived to socket, without wakeup and scheduling delay of the program
+ * @param enable true to enable timestamps
+ */
+void Resolver::setTimestamps(const bool enable) {
+    timestamps = enable;
+    applySocketOptions();
+}
+
+/**
+ * @brief Requests io_uring backend of bulk mode, it is started by next openWindow,
+ * when it is not available (old kernel, disabled by system, kernel timestamps enabled) socket is used directly
+ * @param enable true to use io_uring
+ */
+void Resolver::setIoUring(const bool enable) {
+    io_uring = enable;
+    if (!enable) {
+        uring.stop();
+    }
+}
+
+/**
+ * @brief Resize socket receive and send buffers to configured size, so bursts of responses are not dropped
+ * by kernel before they are read, warns when system limit (net.core.rmem_max, wmem_max) grants less.
+ * Turns on kernel receive timestamps when they are enabled, warns and measures in user space when socket does not support them
+ */
+void Resolver::applySocketOptions() {
+    if (socket_fd == -1) {
+        return;
+    }
+    if (timestamps) {
+#ifdef SO_TIMESTAMPNS
+        const int enable = 1;
+        if (setsockopt(socket_fd, SOL_SOCKET, SO_TIMESTAMPNS, reinterpret_cast<const char*>(&enable), sizeof(enable)) == -1) {
+            warn("Kernel timestamps are not supported by socket, round trip time is measured by program");
+            timestamps = false;
+        }
+#else
+        warn("Kernel timestamps are not supported by system, round trip time is measured by program");
+        timestamps = false;
+#endif
+    }
+    if (pacing.socket_buffer <= 0) {
+        return;
+    }
+    for (const int option : {SO_RCVBUF, SO_SNDBUF}) {
+        setsockopt(socket_fd, SOL_SOCKET, option, reinterpret_cast<const char*>(&pacing.socket_buffer), sizeof(pacing.socket_buffer));
+        // Linux reports double of requested size (bookkeeping overhead)
+        int granted = 0;
+        socklen_t length = sizeof(granted);
+        if (getsockopt(socket_fd, SOL_SOCKET, option, reinterpret_cast<char*>(&granted), &length) == 0 && granted / 2 < pacing.socket_buffer) {
+            warn(string(option == SO_RCVBUF ? "Receive" : "Send") + " buffer of socket is limited to " +
+                 to_string(granted / 2) + " bytes by system");
+        }
+    }
+}
+
+/**
+ * @brief Passes warning to handler of caller, library does not print
+ * @param message text of warning
+ */
+void Resolver::warn(const string& message) const {
+    if (warning_handler) {
+        warning_handler(message);
+    }
+}
+
+/**
+ * @brief Current time for round trip measurement, kernel timestamps are in realtime clock,
+ * so send times are taken from the same clock when they are enabled
+ * @return time in nanoseconds
+ */
+int64_t Resolver::timestampNs() const {
+    if (timestamps) {
+        timespec now{};
+        clock_gettime(CLOCK_REALTIME, &now);
+        return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+    }
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Receive one packet without blocking, with kernel timestamps the receive time is read
+ * from control message of recvmsg
+ * @param buffer buffer of BUFFER_SIZE bytes
+ * @param received time the packet was received (clock of timestampNs)
+ * @return length of packet, -1 when no packet is ready or receiving failed (errno is set)
+ */
+ssize_t Resolver::receivePacket(uint8_t* buffer, int64_t& received) {
+#ifdef SO_TIMESTAMPNS
+    if (timestamps) {
+        iovec data{buffer, BUFFER_SIZE};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(timespec))];
+        msghdr message{};
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        const ssize_t length = recvmsg(socket_fd, &message, MSG_DONTWAIT);
+        if (length == -1) {
+            return -1;
+        }
+        for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_TIMESTAMPNS) {
+                timespec stamp{};
+                memcpy(&stamp, CMSG_DATA(header), sizeof(stamp));
+                received = static_cast<int64_t>(stamp.tv_sec) * 1000000000 + stamp.tv_nsec;
+                return length;
+            }
+        }
+        received = timestampNs();
+        return length;
+    }
+#endif
+    const ssize_t length = recv(socket_fd, reinterpret_cast<char*>(buffer), BUFFER_SIZE, MSG_DONTWAIT);
+    received = timestampNs();
+    return length;
+}
+
+/**
+ * @brief Adds round trip time sample of query answered after its only transmission
+ * (answer of retransmitted query cannot be matched to transmission, Karn's algorithm)
+ * @param sample round trip time in nanoseconds
+ */
+void Resolver::updateRtt(const int64_t sample) {
+    if (sample < 0) {
+        return;
+    }
+    if (srtt == 0) {
+        srtt = sample;
+        rttvar = sample / 2;
+    } else {
+        rttvar = (3 * rttvar + llabs(srtt - sample)) / 4;
+        srtt = (7 * srtt + sample) / 8;
+    }
+    if (stats_enabled) {
+        stats_record(Stage::Rtt, static_cast<uint64_t>(sample));
+    }
+}
+
+/**
+ * @brief Timeout of transmission, RETRANSMIT_TIMEOUT_MS until round trip time is measured
+ * @param transmissions number of previous transmissions of the query
+ * @return time to wait for response before retransmission
+ */
+chrono::milliseconds Resolver::retransmitTimeout(const int transmissions) const {
+    chrono::milliseconds timeout(RETRANSMIT_TIMEOUT_MS);
+    if (srtt > 0) {
+        const auto measured = chrono::duration_cast<chrono::milliseconds>(chrono::nanoseconds(srtt + 4 * rttvar));
+        timeout = clamp(measured, chrono::milliseconds(MIN_RETRANSMIT_TIMEOUT_MS), chrono::milliseconds(RETRANSMIT_TIMEOUT_MS));
+    }
+    return min(timeout * (1 << min(transmissions, 8)), chrono::milliseconds(RETRANSMIT_TIMEOUT_MS));
+}
+
+/**
+ * @brief Close the socket, queries in flight are dropped
+ */
+void Resolver::disconnect() {
+    uring.stop();
+    if (socket_fd != -1) {
+        close(socket_fd);
+        socket_fd = -1;
+    }
+    slots.clear();
+    free_slots.clear();
+    timers = {};
+}
+
+/**
+ * @brief Send query packet to server and wait for response
+ * @param packet query packet
+ * @param response parsed response packet, empty when status is not Ok
+ * @param arena memory resource for parsed response, when nullptr response owns its memory
+ * @param timeout_ms maximum time to wait for response
+ * @return Ok, NotOpen, SendError, ReceiveError or Timeout
+ */
+ResolverStatus Resolver::send(const DNSPacket& packet, optional<DNSPacket>& response, pmr::memory_resource* arena, const int timeout_ms) {
+    response.reset();
+    if (socket_fd == -1) {
+        return ResolverStatus::NotOpen;
+    }
+    // multishot receive of io_uring would take the response, window is started again by openWindow
+    uring.stop();
+
+    uint8_t response_packet[BUFFER_SIZE];
+    const uint64_t query = traceId(next_index++);
+
+    StageTimer encode_timer(Stage::Encode, query);
+    const unique_ptr<uint8_t[]> bytes = packet.getBytes();
+    const size_t size = packet.getSize();
+    encode_timer.stop();
+
+    // Send request to server
+    StageTimer send_timer(Stage::Send, query, 1);
+    trace_async('b', "query", query, send_timer.getStart());
+    trace_flow('s', query, send_timer.getStart());
+    int send_fails = 0;
+    int64_t sent = timestampNs();
+    while (::send(socket_fd, bytes.get(), size, 0) == -1) {
+        stats_count(Counter::SendFails);
+        if (++send_fails >= MAX_TRANSFER_FAILS) {
+            return ResolverStatus::SendError;
+        }
+        sent = timestampNs();
+    }
+    send_timer.stop();
+    stats_count(Counter::Queries);
+    stats_count(Counter::BytesSent, size);
+
+    // Receive response from server
+    StageTimer wait_timer(Stage::Wait, query);
+    const auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+    int recv_fails = 0;
+    ssize_t response_length;
+    int64_t received = 0;
+    while (true) {
+        if (interrupt != nullptr && *interrupt) {
+            return ResolverStatus::Interrupted;
+        }
+        const auto remaining = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+        pollfd fds{};
+        fds.fd = socket_fd;
+        fds.events = POLLIN;
+        if (remaining <= 0 || poll(&fds, 1, static_cast<int>(remaining)) == 0) {
+            stats_count(Counter::Timeouts);
+            trace_async('e', "query", query, trace_now());
+            if (recorder != nullptr) {
+                recorder->record(bytes.get(), size, nullptr, 0, static_cast<uint64_t>(max<int64_t>(0, timestampNs() - sent)));
+            }
+            return ResolverStatus::Timeout;
+        }
+        if ((response_length = receivePacket(response_packet, received)) != -1) {
+            break;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            stats_count(Counter::RecvFails);
+            if (++recv_fails >= MAX_TRANSFER_FAILS) {
+                return ResolverStatus::ReceiveError;
+            }
+        }
+    }
+    wait_timer.stop();
+    stats_count(Counter::Responses);
+    stats_count(Counter::BytesReceived, static_cast<uint64_t>(response_length));
+    response_time = static_cast<uint64_t>(max<int64_t>(0, received - sent));
+    updateRtt(received - sent);
+    if (recorder != nullptr) {
+        recorder->record(bytes.get(), size, response_packet, static_cast<size_t>(response_length), response_time);
+    }
+
+    StageTimer parse_timer(Stage::Parse, query);
+    trace_async('e', "query", query, parse_timer.getStart());
+    trace_flow('f', query, parse_timer.getStart());
+    response.emplace(response_packet, static_cast<size_t>(response_length), arena);
+    parse_timer.stop();
+    return ResolverStatus::Ok;
+}
+
+/**
+ * @brief Transmit pending query and schedule its retransmission
+ * @param slot slot of the query
+ * @return Ok or SendError when sending failed MAX_TRANSFER_FAILS times in a row
+ */
+ResolverStatus Resolver::transmit(const uint16_t slot) {
+    PendingQuery& query = slots[slot];
+    const uint64_t trace_query = traceId(query.index);
+    StageTimer send_timer(Stage::Send, trace_query, static_cast<uint32_t>(query.transmissions + 1));
+    if (query.transmissions == 0) {
+        trace_async('b', "query", trace_query, send_timer.getStart());
+        trace_flow('s', trace_query, send_timer.getStart());
+    } else {
+        trace_flow('t', trace_query, send_timer.getStart());
+    }
+    ResolverStatus status = ResolverStatus::Ok;
+    // send time is taken right before the syscall, after tracing and bookkeeping
+    query.sent = timestampNs();
+    if (query.transmissions == 0) {
+        query.first_sent = query.sent;
+    }
+    if (uring.isOpen()) {
+        // queued send is submitted with other queued sends before caller waits (windowTimeout)
+        if (!uring.queueSend(query.bytes.get(), query.size)) {
+            stats_count(Counter::SendFails);
+            status = ResolverStatus::SendError;
+        } else {
+            stats_count(Counter::BytesSent, query.size);
+        }
+    } else if (::send(socket_fd, query.bytes.get(), query.size, 0) == -1) {
+        stats_count(Counter::SendFails);
+        if (++send_fails >= MAX_TRANSFER_FAILS) {
+            status = ResolverStatus::SendError;
+        }
+    } else {
+        send_fails = 0;
+        stats_count(Counter::BytesSent, query.size);
+    }
+    send_timer.stop();
+    stats_count(query.transmissions > 0 ? Counter::Retransmits : Counter::Queries);
+    const auto now = chrono::steady_clock::now();
+    pacer.consume(now);
+    query.deadline = now + retransmitTimeout(query.transmissions);
+    query.transmissions++;
+    timers.push(Timer{query.deadline, slot, query.serial});
+    return status;
+}
+
+/**
+ * @brief Release slot of answered or given up query
+ * @param slot slot of the query
+ */
+void Resolver::release(const uint16_t slot) {
+    PendingQuery& query = slots[slot];
+    id_slots[query.id] = NO_SLOT;
+    query.serial++;
+    query.bytes.reset();
+    free_slots.push_back(slot);
+}
+
+/**
+ * @brief Check that response answers the question (same name case insensitive, type and class)
+ * @param question sent question
+ * @param received question of received response
+ * @return true if response belongs to question
+ */
+static bool response_matches(const DNSQuestion& question, const DNSQuestion& received) {
+    const pmr::string& sent = question.getName();
+    const pmr::string& received_name = received.getName();
+    const size_t sent_length = !sent.empty() && sent.back() == '.' ? sent.length() - 1 : sent.length();
+    if (sent_length != received_name.length() ||
+        question.getType() != received.getType() ||
+        question.getClass() != received.getClass()) {
+        return false;
+    }
+    for (size_t i = 0; i < sent_length; i++) {
+        if (tolower(static_cast<unsigned char>(sent[i])) != tolower(static_cast<unsigned char>(received_name[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Check that unparsed response answers the question, only its question section is parsed (name on stack)
+ * @param question sent question
+ * @param packet received packet, at least header long
+ * @param length length of packet
+ * @return true if response belongs to question
+ */
+static bool raw_response_matches(const DNSQuestion& question, const uint8_t* packet, const size_t length) {
+    if (DNSHeader(packet).getQdcount() == 0) {
+        return false;
+    }
+    char buffer[MAX_NAME_LENGTH + 1];
+    pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+    WireReader reader(packet, length, sizeof(WireHeader));
+    const DNSQuestion received(reader, &arena);
+    return reader.isValid() && response_matches(question, received);
+}
+
+/**
+ * @brief Prepare window for up to window queries in flight, each query is identified by its own ID
+ * @param window maximum number of queries in flight
+ * @return Ok or NotOpen
+ */
+ResolverStatus Resolver::openWindow(size_t window) {
+    if (socket_fd == -1) {
+        return ResolverStatus::NotOpen;
+    }
+
+    window = max<size_t>(1, min(window, MAX_WINDOW));
+    slots = vector<PendingQuery>(window);
+    free_slots.clear();
+    for (size_t i = window; i > 0; i--) {
+        free_slots.push_back(static_cast<uint16_t>(i - 1));
+    }
+    id_slots.assign(0x10000, NO_SLOT);
+    timers = {};
+    // slots of window track queries, pacer caps how many of them are in flight
+    pacer.configure(pacing.qps, pacing.max_in_flight > 0 ? min(window, pacing.max_in_flight) : window);
+
+    if (io_uring && !uring.isOpen()) {
+        string reason = "kernel timestamps need recvmsg";
+        if (timestamps || !uring.open(socket_fd, reason)) {
+            warn("io_uring backend is not available (" + reason + "), socket is used");
+            io_uring = false;
+        }
+    }
+    next_id = static_cast<uint16_t>(getpid() + reinterpret_cast<uintptr_t>(this));
+    return ResolverStatus::Ok;
+}
+
+/**
+ * @brief Encode and send question, window must not be full
+ * @param question question to send
+ * @param recursion recursion desired
+ * @param index index of query passed to response handler
+ * @return Ok or SendError (query stays in window and is retransmitted)
+ */
+ResolverStatus Resolver::submit(const DNSQuestion& question, const bool recursion, size_t& index) {
+    while (id_slots[next_id] != NO_SLOT) {
+        next_id++;
+    }
+
+    const uint16_t slot = free_slots.back();
+    free_slots.pop_back();
+    PendingQuery& query = slots[slot];
+    query.index = next_index++;
+    query.question = question;
+    query.id = next_id++;
+    query.transmissions = 0;
+    StageTimer encode_timer(Stage::Encode, traceId(query.index));
+    const DNSPacket packet(DNSHeader(recursion, query.id), query.question);
+    query.bytes = packet.getBytes();
+    query.size = packet.getSize();
+    encode_timer.stop();
+    id_slots[query.id] = slot;
+    index = query.index;
+    return transmit(slot);
+}
+
+/**
+ * @brief Time until the earliest retransmission deadline or the next token of pacing,
+ * sends queued by io_uring backend are submitted
+ * @return timeout in milliseconds for poll, -1 when no query is in flight and no query waits for token
+ */
+int Resolver::windowTimeout() {
+    // Caller is going to wait, sends queued in io_uring are submitted in one system call
+    if (uring.isOpen() && !uring.flush()) {
+        stats_count(Counter::SendFails);
+    }
+    // Drop timer entries of completed queries
+    while (!timers.empty() && slots[timers.top().slot].serial != timers.top().serial) {
+        timers.pop();
+    }
+    const auto now = chrono::steady_clock::now();
+    const int token_delay = free_slots.empty() ? -1 : pacer.delay(now);
+    if (timers.empty()) {
+        return token_delay;
+    }
+    const auto remaining = chrono::duration_cast<chrono::milliseconds>(timers.top().deadline - now);
+    const int deadline = static_cast<int>(max<chrono::milliseconds::rep>(0, remaining.count() + 1));
+    return token_delay >= 0 ? min(deadline, token_delay) : deadline;
+}
+
+/**
+ * @brief Matches received packet to query in flight and passes it to handler, parsed or as it is
+ * @param packet received packet
+ * @param length length of packet
+ * @param received time the packet was received (clock of timestampNs)
+ * @param delivery handler called for answered question
+ */
+void Resolver::handlePacket(const uint8_t* packet, const size_t length, const int64_t received, const Delivery& delivery) {
+    stats_count(Counter::BytesReceived, length);
+    if (length < sizeof(WireHeader)) {
+        return;
+    }
+    const uint16_t id = reinterpret_cast<const WireHeader*>(packet)->id;
+    const uint16_t slot = id_slots[id];
+    if (slot == NO_SLOT) {
+        return; // late response of query answered or given up before
+    }
+    PendingQuery& query = slots[slot];
+
+    // Raw responses are matched by their question only, the rest is parsed by consumer of handler
+    optional<DNSPacket> response;
+    bool matches;
+    if (delivery.raw != nullptr) {
+        const uint64_t matched = trace_now();
+        trace_async('e', "query", traceId(query.index), matched);
+        trace_flow('f', traceId(query.index), matched);
+        matches = raw_response_matches(query.question, packet, length);
+    } else {
+        if (batched++ == ARENA_BATCH_SIZE && delivery.arena != nullptr) {
+            delivery.arena->reset();
+            batched = 1;
+        }
+        StageTimer parse_timer(Stage::Parse, traceId(query.index));
+        trace_async('e', "query", traceId(query.index), parse_timer.getStart());
+        trace_flow('f', traceId(query.index), parse_timer.getStart());
+        response.emplace(packet, length, delivery.arena);
+        parse_timer.stop();
+        matches = response_matches(query.question, response->getQuestion());
+    }
+    if (!matches) {
+        warn("Response does not match question '" + query.question.getNameDot() + "'");
+        return;
+    }
+    stats_count(Counter::Responses);
+    response_time = static_cast<uint64_t>(max<int64_t>(0, received - query.first_sent));
+    if (query.transmissions == 1) {
+        updateRtt(received - query.sent);
+    }
+    if (recorder != nullptr) {
+        recorder->record(query.bytes.get(), query.size, packet, length, response_time);
+    }
+    // REFUSED is how rate limiting upstream sheds load, it slows down sending like loss
+    if (DNSHeader(packet).getRcode() == 5) {
+        pacer.congestion(chrono::steady_clock::now());
+    } else {
+        pacer.success();
+    }
+    if (delivery.raw != nullptr) {
+        (*delivery.raw)(query.index, query.question, packet, length);
+    } else {
+        (*delivery.parsed)(query.index, query.question, &*response);
+    }
+    release(slot);
+}
+
+/**
+ * @brief Receive all responses ready on socket without blocking and pass them to handler
+ * @param handle_response handler called for each answered question
+ * @param arena memory resource for parsed responses, reset after each batch of responses
+ * @return Ok or ReceiveError when receiving failed MAX_TRANSFER_FAILS times in a row
+ */
+ResolverStatus Resolver::receive(const ResponseHandler& handle_response, Arena* arena) {
+    return receive(Delivery{&handle_response, nullptr, arena});
+}
+
+/**
+ * @brief Receive all responses ready on socket without blocking and pass them to handler unparsed
+ * @param handle_response handler called for each answered question
+ * @return Ok or ReceiveError when receiving failed MAX_TRANSFER_FAILS times in a row
+ */
+ResolverStatus Resolver::receiveRaw(const RawResponseHandler& handle_response) {
+    return receive(Delivery{nullptr, &handle_response, nullptr});
+}
+
+/**
+ * @brief Receive all responses ready on socket without blocking and pass them to handler of delivery
+ * @param delivery handler called for each answered question
+ * @return Ok or ReceiveError when receiving failed MAX_TRANSFER_FAILS times in a row
+ */
+ResolverStatus Resolver::receive(const Delivery& delivery) {
+    if (uring.isOpen()) {
+        return receiveUring(delivery);
+    }
+
+    uint8_t response_packet[BUFFER_SIZE];
+    ssize_t response_length;
+    int64_t received = 0;
+    while ((response_length = receivePacket(response_packet, received)) != -1) {
+        recv_fails = 0;
+        handlePacket(response_packet, static_cast<size_t>(response_length), received, delivery);
+    }
+
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        stats_count(Counter::RecvFails);
+        if (++recv_fails >= MAX_TRANSFER_FAILS) {
+            return ResolverStatus::ReceiveError;
+        }
+    }
+    return ResolverStatus::Ok;
+}
+
+/**
+ * @brief Pass responses completed by io_uring backend to handler, packets are used directly
+ * in buffers of provided buffer ring, which are returned to kernel after handler returns.
+ * When kernel rejects multishot receive, backend is closed and socket is used directly
+ * @param delivery handler called for each answered question
+ * @return Ok, SendError or ReceiveError when sending or receiving failed MAX_TRANSFER_FAILS times in a row
+ */
+ResolverStatus Resolver::receiveUring(const Delivery& delivery) {
+    UringPacket packet;
+    int result;
+    while ((result = uring.nextPacket(packet)) > 0) {
+        recv_fails = 0;
+        handlePacket(packet.data, packet.length, timestampNs(), delivery);
+        uring.recycle(packet.buffer);
+    }
+
+    const unsigned failed_sends = uring.takeSendFails();
+    if (failed_sends > 0) {
+        stats_count(Counter::SendFails, failed_sends);
+        send_fails += static_cast<int>(failed_sends);
+        if (send_fails >= MAX_TRANSFER_FAILS) {
+            return ResolverStatus::SendError;
+        }
+    }
+    if (result == -EINVAL || result == -EOPNOTSUPP) {
+        warn("Kernel does not support multishot receive of io_uring, socket is used");
+        uring.stop();
+        io_uring = false;
+        return receive(delivery);
+    }
+    if (result < 0) {
+        stats_count(Counter::RecvFails);
+        if (++recv_fails >= MAX_TRANSFER_FAILS) {
+            return ResolverStatus::ReceiveError;
+        }
+    }
+    return ResolverStatus::Ok;
+}
+
+/**
+ * @brief Retransmit queries with passed deadline, queries without response after all retransmissions are given up
+ * @param handle_response handler called with nullptr response for each given up question
+ * @return Ok or SendError when retransmission failed MAX_TRANSFER_FAILS times in a row
+ */
+ResolverStatus Resolver::expire(const ResponseHandler& handle_response) {
+    return expire(Delivery{&handle_response, nullptr, nullptr});
+}
+
+/**
+ * @brief Retransmit queries with passed deadline, queries without response after all retransmissions are given up
+ * @param handle_response handler called with nullptr packet for each given up question
+ * @return Ok or SendError when retransmission failed MAX_TRANSFER_FAILS times in a row
+ */
+ResolverStatus Resolver::expireRaw(const RawResponseHandler& handle_response) {
+    return expire(Delivery{nullptr, &handle_response, nullptr});
+}
+
+/**
+ * @brief Retransmit queries with passed deadline, queries without response after all retransmissions are given up
+ * @param delivery handler called for each given up question
+ * @return Ok or SendError when retransmission failed MAX_TRANSFER_FAILS times in a row
+ */
+ResolverStatus Resolver::expire(const Delivery& delivery) {
+    const auto now = chrono::steady_clock::now();
+    while (!timers.empty()) {
+        const Timer timer = timers.top();
+        PendingQuery& query = slots[timer.slot];
+        if (query.serial != timer.serial) {
+            timers.pop();
+            continue;
+        }
+        if (timer.deadline > now) {
+            break;
+        }
+        timers.pop();
+        const uint16_t slot = timer.slot;
+        pacer.congestion(now);
+        if (query.transmissions <= MAX_RETRANSMITS) {
+            const ResolverStatus status = transmit(slot);
+            if (status != ResolverStatus::Ok) {
+                return status;
+            }
+        } else {
+            stats_count(Counter::Timeouts);
+            trace_async('e', "query", traceId(query.index), trace_now());
+            if (recorder != nullptr) {
+                recorder->record(query.bytes.get(), query.size, nullptr, 0, static_cast<uint64_t>(max<int64_t>(0, timestampNs() - query.first_sent)));
+            }
+            if (delivery.raw != nullptr) {
+                (*delivery.raw)(query.index, query.question, nullptr, 0);
+            } else {
+                (*delivery.parsed)(query.index, query.question, nullptr);
+            }
+            release(slot);
+        }
+    }
+    return ResolverStatus::Ok;
+}
+
+/**
+ * @brief Send questions pipelined with up to window queries in flight
+ * @param next_question source of questions
+ * @param handle_response handler called for each answered or timed out question
+ * @param recursion recursion desired
+ * @param window maximum number of queries in flight
+ * @param arena memory resource for parsed responses, reset after each batch of responses
+ * @return Ok when all questions were answered or given up, otherwise first error
+ */
+ResolverStatus Resolver::sendWindow(const QuerySource& next_question, const ResponseHandler& handle_response, const bool recursion,
+                                    const size_t window, Arena* arena) {
+    return runWindow(next_question, Delivery{&handle_response, nullptr, arena}, recursion, window);
+}
+
+/**
+ * @brief Send questions pipelined with up to window queries in flight, responses are passed to handler unparsed
+ * (e.g. to be parsed by another thread)
+ * @param next_question source of questions
+ * @param handle_response handler called for each answered or timed out question
+ * @param recursion recursion desired
+ * @param window maximum number of queries in flight
+ * @return Ok when all questions were answered or given up, otherwise first error
+ */
+ResolverStatus Resolver::sendWindowRaw(const QuerySource& next_question, const RawResponseHandler& handle_response,
+                                       const bool recursion, const size_t window) {
+    return runWindow(next_question, Delivery{nullptr, &handle_response, nullptr}, recursion, window);
+}
+
+/**
+ * @brief Send questions pipelined with up to window queries in flight
+ * @param next_question source of questions
+ * @param delivery handler called for each answered or timed out question
+ * @param recursion recursion desired
+ * @param window maximum number of queries in flight
+ * @return Ok when all questions were answered or given up, otherwise first error
+ */
+ResolverStatus Resolver::runWindow(const QuerySource& next_question, const Delivery& delivery, const bool recursion,
+                                   const size_t window) {
+    ResolverStatus status = openWindow(window);
+    bool exhausted = false;
+
+    while (status == ResolverStatus::Ok) {
+        if (interrupt != nullptr && *interrupt) {
+            return ResolverStatus::Interrupted;
+        }
+        // Fill the window with new queries
+        while (!exhausted && !windowFull() && status == ResolverStatus::Ok) {
+            DNSQuestion question;
+            if (!next_question(question)) {
+                exhausted = true;
+                break;
+            }
+            size_t index;
+            status = submit(question, recursion, index);
+        }
+
+        if (status != ResolverStatus::Ok || (exhausted && windowEmpty())) {
+            break;
+        }
+
+        // Wait for responses until the earliest deadline (ring descriptor when io_uring receives them)
+        pollfd fds{};
+        fds.fd = getSocket();
+        fds.events = POLLIN;
+        // token of pacer that became available after windowFull gives no timeout, next question is sent right away
+        int timeout = windowTimeout();
+        if (timeout < 0 && !exhausted) {
+            timeout = 0;
+        }
+        StageTimer wait_timer(Stage::Wait);
+        const int ready = poll(&fds, 1, timeout);
+        wait_timer.stop();
+        if (ready > 0 && (fds.revents & POLLIN)) {
+            status = receive(delivery);
+        }
+
+        if (status == ResolverStatus::Ok) {
+            status = expire(delivery);
+        }
+    }
+    return status;
+}
@@ -0,0 +1,250 @@
+/**
+ * @file resolver.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of reentrant dns resolver, part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <chrono>
+#include <csignal>
+#include <optional>
+#include <queue>
+
+#include "dns.h"
+#include "pacer.h"
+#include "replay.h"
+#include "resolvconf.h"
+#include "trace.h"
+#include "uring.h"
+
+// number of queries in flight in bulk mode
+constexpr size_t DEFAULT_WINDOW = 64;
+constexpr size_t MAX_WINDOW = 4096;
+// timeout of one transmission in bulk mode and number of retransmissions before the query is given up
+constexpr int RETRANSMIT_TIMEOUT_MS = 1000;
+constexpr int MAX_RETRANSMITS = 3;
+// once round trip time is measured, timeout of first transmission is smoothed RTT + 4 * RTT variance (RFC 6298)
+// bounded by MIN_RETRANSMIT_TIMEOUT_MS and RETRANSMIT_TIMEOUT_MS, each retransmission doubles it up to RETRANSMIT_TIMEOUT_MS
+constexpr int MIN_RETRANSMIT_TIMEOUT_MS = 200;
+
+// returns next question to send, false when there are no more questions
+using QuerySource = function<bool(DNSQuestion& question)>;
+// called for each question in order of completion, response is nullptr when all transmissions timed out
+using ResponseHandler = function<void(size_t index, const DNSQuestion& question, const DNSPacket* response)>;
+// like ResponseHandler, but response is passed unparsed (packet is nullptr when all transmissions timed out),
+// packet is valid only during the call
+using RawResponseHandler = function<void(size_t index, const DNSQuestion& question, const uint8_t* packet, size_t length)>;
+
+/**
+ * @brief Result of resolver operation, resolver never exits program
+ */
+enum class ResolverStatus {
+    Ok,
+    ServerError,    // server address cannot be resolved
+    SocketError,    // socket cannot be created or connected
+    NotOpen,        // resolver is not open
+    SendError,      // sending failed MAX_TRANSFER_FAILS times in a row
+    ReceiveError,   // receiving failed MAX_TRANSFER_FAILS times in a row
+    Timeout,        // server did not respond in time
+    ProtocolError,  // response cannot be used (e.g. refused or malformed zone transfer), details in getError
+    Interrupted,    // interrupt flag of caller was set (e.g. by its signal handler)
+};
+
+const char* resolver_status_string(ResolverStatus status);
+
+/**
+ * @brief Resolver owning its socket, server address and state of queries in flight.
+ * Resolver does not install signal handlers, does not exit program and does not print, errors are returned as status
+ * and warnings are passed to warning handler of caller, independent resolvers can be used from different threads at the same time
+ */
+class Resolver {
+public:
+    Resolver() = default;
+    ~Resolver() {
+        disconnect();
+    }
+    Resolver(const Resolver&) = delete;
+    Resolver& operator=(const Resolver&) = delete;
+
+    ResolverStatus open(const string& host, uint16_t port);
+    ResolverStatus open(const vector<ServerAddress>& addresses);
+    void disconnect();
+
+    ResolverStatus send(const DNSPacket& packet, optional<DNSPacket>& response, pmr::memory_resource* arena = nullptr,
+                        int timeout_ms = MAX_RESPONSE_WAIT_SEC * 1000);
+    ResolverStatus sendWindow(const QuerySource& next_question, const ResponseHandler& handle_response, bool recursion,
+                              size_t window, Arena* arena);
+    ResolverStatus sendWindowRaw(const QuerySource& next_question, const RawResponseHandler& handle_response, bool recursion,
+                                 size_t window);
+
+    void setPacing(const PacingConfig& config);
+    void setTimestamps(bool enable);
+    void setIoUring(bool enable);
+    // send and bulk loops return Interrupted once flag is set, flag is checked at least once per retransmission timeout
+    void setInterrupt(const volatile sig_atomic_t* flag) {
+        interrupt = flag;
+    }
+    // without handler warnings are dropped
+    void setWarningHandler(WarningHandler handler) {
+        warning_handler = move(handler);
+    }
+    // trace events of this resolver carry scope in upper bits of query number, so events of resolvers numbering
+    // their queries independently (e.g. one per server in comparison mode) do not match each other in trace viewer
+    void setTraceScope(const uint32_t scope) {
+        trace_base = static_cast<uint64_t>(scope) << TRACE_SCOPE_SHIFT;
+    }
+    // query number of query with given index in trace events, stages of caller (e.g. parse stage of pipeline) use it
+    // to join spans of the query, single queries of send take next index like queries of window
+    uint64_t traceId(const size_t index) const {
+        return trace_base + index + 1;
+    }
+    // every query with its response (or without it when given up) and latency is written to session log
+    void setRecorder(SessionRecorder* session_recorder) {
+        recorder = session_recorder;
+    }
+
+    ResolverStatus openWindow(size_t window);
+    // no free slot, or pacing does not allow next query yet (windowTimeout wakes caller when it does)
+    bool windowFull() const {
+        return free_slots.empty() || !pacer.ready(slots.size() - free_slots.size(), SendPacer::Clock::now());
+    }
+    bool windowEmpty() const {
+        return free_slots.size() == slots.size();
+    }
+    ResolverStatus submit(const DNSQuestion& question, bool recursion, size_t& index);
+    int windowTimeout();
+    ResolverStatus receive(const ResponseHandler& handle_response, Arena* arena);
+    ResolverStatus expire(const ResponseHandler& handle_response);
+    ResolverStatus receiveRaw(const RawResponseHandler& handle_response);
+    ResolverStatus expireRaw(const RawResponseHandler& handle_response);
+
+    bool isOpen() const {
+        return socket_fd != -1;
+    }
+    // descriptor readable when responses are ready, for polling together with other sockets
+    // (socket connected to server, or ring of io_uring backend)
+    int getSocket() const {
+        return uring.isOpen() ? uring.getFd() : socket_fd;
+    }
+    // bulk mode sends and receives through io_uring
+    bool usesIoUring() const {
+        return uring.isOpen();
+    }
+    // details of the last error (e.g. reason of failed server address resolution)
+    const string& getError() const {
+        return error;
+    }
+    const SendPacer& getPacer() const {
+        return pacer;
+    }
+    // time from the first transmission to receipt of response passed to the handler being called, in nanoseconds
+    uint64_t getResponseTime() const {
+        return response_time;
+    }
+    // smoothed round trip time of server in nanoseconds, 0 before the first measurement
+    uint64_t getSmoothedRtt() const {
+        return static_cast<uint64_t>(srtt);
+    }
+    // receive times are taken by kernel (SO_TIMESTAMPNS), otherwise after recv returns
+    bool hasKernelTimestamps() const {
+        return timestamps;
+    }
+
+private:
+    /**
+     * @brief Query waiting for response in bulk mode
+     */
+    struct PendingQuery {
+        size_t index = 0;
+        DNSQuestion question;
+        unique_ptr<uint8_t[]> bytes;
+        size_t size = 0;
+        uint16_t id = 0;
+        int transmissions = 0;
+        // times of the first and the last transmission (clock of timestampNs)
+        int64_t first_sent = 0;
+        int64_t sent = 0;
+        chrono::steady_clock::time_point deadline;
+        // incremented when slot is reused, invalidates old timer entries
+        uint32_t serial = 0;
+    };
+
+    /**
+     * @brief Handler of receive and expire, responses are parsed for parsed handler and passed as they are to raw one
+     */
+    struct Delivery {
+        const ResponseHandler* parsed = nullptr;
+        const RawResponseHandler* raw = nullptr;
+        // memory resource for parsed responses, reset after each batch of responses
+        Arena* arena = nullptr;
+    };
+
+    /**
+     * @brief Retransmission deadline of one transmission, entries of completed queries are skipped by serial
+     */
+    struct Timer {
+        chrono::steady_clock::time_point deadline;
+        uint16_t slot = 0;
+        uint32_t serial = 0;
+
+        bool operator>(const Timer& other) const {
+            return deadline > other.deadline;
+        }
+    };
+
+    // maps query ID to slot, window is smaller than number of IDs so NO_SLOT marks unused ID
+    static constexpr uint16_t NO_SLOT = 0xffff;
+
+    ResolverStatus transmit(uint16_t slot);
+    void release(uint16_t slot);
+    void applySocketOptions();
+    void warn(const string& message) const;
+    int64_t timestampNs() const;
+    ssize_t receivePacket(uint8_t* buffer, int64_t& received);
+    void handlePacket(const uint8_t* packet, size_t length, int64_t received, const Delivery& delivery);
+    ResolverStatus receive(const Delivery& delivery);
+    ResolverStatus receiveUring(const Delivery& delivery);
+    ResolverStatus expire(const Delivery& delivery);
+    ResolverStatus runWindow(const QuerySource& next_question, const Delivery& delivery, bool recursion, size_t window);
+    void updateRtt(int64_t sample);
+    chrono::milliseconds retransmitTimeout(int transmissions) const;
+
+    int socket_fd = -1;
+    string error;
+    // added to query numbers of trace events (scope << TRACE_SCOPE_SHIFT)
+    uint64_t trace_base = 0;
+
+    vector<PendingQuery> slots;
+    vector<uint16_t> free_slots;
+    vector<uint16_t> id_slots;
+    // min-heap of deadlines, timeouts differ by RTT and number of transmissions, so sending order is not deadline order
+    priority_queue<Timer, vector<Timer>, greater<Timer>> timers;
+    uint16_t next_id = 0;
+    size_t next_index = 0;
+    size_t batched = 0;
+    int send_fails = 0;
+    int recv_fails = 0;
+
+    PacingConfig pacing;
+    SendPacer pacer;
+
+    bool timestamps = false;
+    // smoothed round trip time and its variance in nanoseconds
+    int64_t srtt = 0;
+    int64_t rttvar = 0;
+    uint64_t response_time = 0;
+
+    // io_uring backend is requested, it is started by openWindow
+    bool io_uring = false;
+    UringBackend uring;
+
+    SessionRecorder* recorder = nullptr;
+    const volatile sig_atomic_t* interrupt = nullptr;
+    WarningHandler warning_handler;
+};
+
+#endif // RESOLVER_H
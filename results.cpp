@@ -0,0 +1,443 @@
+/**
+ * @file results.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of compact columnar store of resolved records and its aggregations, part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "results.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <unordered_map>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+/**
+ * @brief Copies name in lower case, names are compared case insensitively
+ * @param name domain name
+ * @param result lower case name, buffer is reused
+ * @return result
+ */
+static const string& lower_name(const string_view name, string& result) {
+    result.assign(name);
+    for (char& c : result) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+MappedBuffer::~MappedBuffer() {
+#if !defined(_WIN32) && !defined(_WIN64)
+    if (memory != nullptr) {
+        munmap(memory, reserved);
+    }
+    if (fd != -1) {
+        close(fd);
+    }
+#else
+    free(memory);
+#endif
+}
+
+/**
+ * @brief Makes room for bytes, capacity doubles. Anonymous mapping is copied to larger one,
+ * spilled buffer extends its file and maps it again
+ * @param bytes required size
+ * @return false when memory or file cannot grow
+ */
+bool MappedBuffer::reserve(const size_t bytes) {
+    if (bytes <= reserved) {
+        return true;
+    }
+    size_t capacity = max(reserved, RESULTS_INITIAL_CAPACITY);
+    while (capacity < bytes) {
+        capacity *= 2;
+    }
+#if !defined(_WIN32) && !defined(_WIN64)
+    void* grown;
+    if (fd != -1) {
+        if (ftruncate(fd, static_cast<off_t>(capacity)) == -1) {
+            return false;
+        }
+        grown = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    } else {
+        grown = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (grown != MAP_FAILED && length > 0) {
+            memcpy(grown, memory, length);
+        }
+    }
+    if (grown == MAP_FAILED) {
+        return false;
+    }
+    if (memory != nullptr) {
+        munmap(memory, reserved);
+    }
+#else
+    void* grown = realloc(memory, capacity);
+    if (grown == nullptr) {
+        return false;
+    }
+#endif
+    memory = static_cast<uint8_t*>(grown);
+    reserved = capacity;
+    return true;
+}
+
+/**
+ * @brief Appends bytes at the end of buffer
+ * @param bytes appended data
+ * @param size number of bytes
+ * @return false when buffer cannot grow
+ */
+bool MappedBuffer::append(const void* bytes, const size_t size) {
+    if (!reserve(length + size)) {
+        return false;
+    }
+    if (size > 0) {
+        memcpy(memory + length, bytes, size);
+    }
+    length += size;
+    return true;
+}
+
+/**
+ * @brief Moves buffer to unlinked file of directory, file is removed by system when buffer is destroyed
+ * @param directory directory of file
+ * @param error reason why buffer cannot be moved
+ * @return true when buffer is backed by file
+ */
+bool MappedBuffer::spill(const string& directory, string& error) {
+    if (fd != -1) {
+        return true;
+    }
+#if !defined(_WIN32) && !defined(_WIN64)
+    string path = directory + "/dns-results-XXXXXX";
+    fd = mkstemp(path.data());
+    if (fd == -1) {
+        error = "Spill file cannot be created in directory '" + directory + "'";
+        return false;
+    }
+    unlink(path.c_str());
+    const size_t capacity = max(reserved, RESULTS_INITIAL_CAPACITY);
+    void* file = ftruncate(fd, static_cast<off_t>(capacity)) == 0
+                     ? mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (file == MAP_FAILED) {
+        close(fd);
+        fd = -1;
+        error = "Spill file in directory '" + directory + "' cannot be mapped";
+        return false;
+    }
+    if (memory != nullptr) {
+        memcpy(file, memory, length);
+        munmap(memory, reserved);
+    }
+    memory = static_cast<uint8_t*>(file);
+    reserved = capacity;
+    return true;
+#else
+    error = "Spilling results to file is not supported on this system";
+    return false;
+#endif
+}
+
+/**
+ * @brief Creates empty store
+ * @param spill_directory directory of files of columns, empty to keep columns in memory
+ * @param spill_threshold memory of columns above which they are moved to files
+ */
+ResultStore::ResultStore(string spill_directory, const size_t spill_threshold) :
+    spill_directory(move(spill_directory)), spill_threshold(spill_threshold) {}
+
+/**
+ * @brief Hash of name (FNV-1a)
+ * @param name lower case name
+ * @return 64-bit hash
+ */
+uint64_t ResultStore::nameHash(const string_view name) {
+    uint64_t value = 0xcbf29ce484222325;
+    for (const char c : name) {
+        value ^= static_cast<uint8_t>(c);
+        value *= 0x100000001b3;
+    }
+    return value;
+}
+
+/**
+ * @brief Interned name
+ * @param id id of name
+ * @return lower case name with trailing dot, valid until next record is added
+ */
+string_view ResultStore::name(const uint32_t id) const {
+    const uint64_t start = name_offsets[id];
+    const uint64_t end = id + 1 < name_offsets.size() ? name_offsets[id + 1] : name_bytes.size();
+    return {reinterpret_cast<const char*>(name_bytes.data()) + start, static_cast<size_t>(end - start)};
+}
+
+/**
+ * @brief Record data as text
+ * @param record index of record
+ * @return data of record, valid until next record is added
+ */
+string_view ResultStore::rdata(const size_t record) const {
+    return {reinterpret_cast<const char*>(rdata_bytes.data()) + rdata_offsets[record], rdata_lengths[record]};
+}
+
+/**
+ * @brief Doubles index of names and inserts all names again
+ * @return false when index cannot grow
+ */
+bool ResultStore::growIndex() {
+    const size_t size = max<size_t>(1024, name_index.size() * 2);
+    try {
+        name_index.assign(size, RESULTS_NO_NAME);
+    } catch (const bad_alloc&) {
+        return false;
+    }
+    for (uint32_t id = 0; id < name_offsets.size(); id++) {
+        size_t slot = nameHash(name(id)) & (size - 1);
+        while (name_index[slot] != RESULTS_NO_NAME) {
+            slot = (slot + 1) & (size - 1);
+        }
+        name_index[slot] = id;
+    }
+    return true;
+}
+
+/**
+ * @brief Looks up id of name
+ * @param name lower case name
+ * @return id of name, RESULTS_NO_NAME when name was not interned
+ */
+uint32_t ResultStore::find(const string_view name) const {
+    if (name_index.empty()) {
+        return RESULTS_NO_NAME;
+    }
+    const size_t mask = name_index.size() - 1;
+    for (size_t slot = nameHash(name) & mask; name_index[slot] != RESULTS_NO_NAME; slot = (slot + 1) & mask) {
+        if (this->name(name_index[slot]) == name) {
+            return name_index[slot];
+        }
+    }
+    return RESULTS_NO_NAME;
+}
+
+/**
+ * @brief Returns id of name, name seen for the first time is stored
+ * @param name lower case name
+ * @return id of name, RESULTS_NO_NAME when name cannot be stored
+ */
+uint32_t ResultStore::intern(const string_view name) {
+    // load factor at most one half keeps probe sequences short
+    if ((name_offsets.size() + 1) * 2 > name_index.size() && !growIndex()) {
+        return RESULTS_NO_NAME;
+    }
+    const size_t mask = name_index.size() - 1;
+    size_t slot = nameHash(name) & mask;
+    for (; name_index[slot] != RESULTS_NO_NAME; slot = (slot + 1) & mask) {
+        if (this->name(name_index[slot]) == name) {
+            return name_index[slot];
+        }
+    }
+    const auto id = static_cast<uint32_t>(name_offsets.size());
+    if (id == RESULTS_NO_NAME || !name_offsets.push_back(name_bytes.size()) || !name_bytes.append(name.data(), name.size())) {
+        return RESULTS_NO_NAME;
+    }
+    name_index[slot] = id;
+    return id;
+}
+
+/**
+ * @brief Moves all columns to files of spill directory
+ * @return false when some column cannot be moved
+ */
+bool ResultStore::spillColumns() {
+    for (MappedBuffer* buffer : {&name_bytes, &name_offsets.getBuffer(), &owners.getBuffer(), &types.getBuffer(),
+                                 &classes.getBuffer(), &ttls.getBuffer(), &rdata_offsets.getBuffer(),
+                                 &rdata_lengths.getBuffer(), &queries.getBuffer(), &rdata_bytes}) {
+        if (!buffer->spill(spill_directory, error)) {
+            return false;
+        }
+    }
+    spilled = true;
+    return true;
+}
+
+/**
+ * @brief Memory of all columns and index of names
+ * @return bytes
+ */
+size_t ResultStore::getMemory() const {
+    return name_bytes.capacity() + name_offsets.getBuffer().capacity() + owners.getBuffer().capacity() +
+           types.getBuffer().capacity() + classes.getBuffer().capacity() + ttls.getBuffer().capacity() +
+           rdata_offsets.getBuffer().capacity() + rdata_lengths.getBuffer().capacity() +
+           queries.getBuffer().capacity() + rdata_bytes.capacity() + name_index.size() * sizeof(uint32_t);
+}
+
+/**
+ * @brief Appends answer records of response, columns are moved to files when their memory exceeds spill threshold
+ * @param query index of query (output item) the response belongs to
+ * @param response parsed response
+ * @return false when store cannot grow, reason is in error
+ */
+bool ResultStore::add(const uint32_t query, const DNSPacket& response) {
+    responses++;
+    for (const DNSRecord& record : response.getAnswers()) {
+        const uint32_t owner = intern(lower_name(record.getNameView(), scratch_name));
+        scratch_rdata.clear();
+        record.appendRdata(scratch_rdata);
+        const size_t length = min<size_t>(scratch_rdata.size(), UINT16_MAX);
+        if (owner == RESULTS_NO_NAME || !owners.push_back(owner) || !types.push_back(record.getTypeValue()) ||
+            !classes.push_back(record.getClassValue()) || !ttls.push_back(record.getTtl()) ||
+            !rdata_offsets.push_back(rdata_bytes.size()) || !rdata_lengths.push_back(static_cast<uint16_t>(length)) ||
+            !queries.push_back(query) || !rdata_bytes.append(scratch_rdata.data(), length)) {
+            error = "Result store cannot grow, memory or disk space is exhausted";
+            return false;
+        }
+    }
+    if (!spill_directory.empty() && !spilled && getMemory() > spill_threshold) {
+        return spillColumns();
+    }
+    return true;
+}
+
+/**
+ * @brief Groups records by type and data, counts records and distinct owner names of each group
+ * @param limit maximum number of returned groups
+ * @return groups with the most records first
+ */
+vector<RdataGroup> ResultStore::groupByRdata(const size_t limit) const {
+    /**
+     * @brief Key of group, data point into column of record data
+     */
+    struct Key {
+        uint16_t type;
+        string_view rdata;
+
+        bool operator==(const Key& other) const {
+            return type == other.type && rdata == other.rdata;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return hash<string_view>()(key.rdata) ^ key.type;
+        }
+    };
+
+    const size_t records = getRecords();
+    unordered_map<Key, uint32_t, KeyHash> groups;
+    vector<RdataGroup> result;
+    // (group, owner) of each record, sorted to count distinct owners
+    vector<uint64_t> members;
+    members.reserve(records);
+    const uint16_t* type_column = types.data();
+    const uint32_t* owner_column = owners.data();
+    for (size_t i = 0; i < records; i++) {
+        const auto [group, inserted] = groups.try_emplace(Key{type_column[i], rdata(i)}, static_cast<uint32_t>(result.size()));
+        if (inserted) {
+            result.push_back({type_column[i], string(group->first.rdata), 0, 0});
+        }
+        result[group->second].records++;
+        members.push_back(static_cast<uint64_t>(group->second) << 32 | owner_column[i]);
+    }
+    sort(members.begin(), members.end());
+    members.erase(unique(members.begin(), members.end()), members.end());
+    for (const uint64_t member : members) {
+        result[member >> 32].owners++;
+    }
+
+    const auto more = [](const RdataGroup& a, const RdataGroup& b) {
+        return a.records != b.records ? a.records > b.records : a.owners != b.owners ? a.owners > b.owners : a.rdata < b.rdata;
+    };
+    const size_t kept = min(limit, result.size());
+    partial_sort(result.begin(), result.begin() + static_cast<ptrdiff_t>(kept), result.end(), more);
+    result.resize(kept);
+    return result;
+}
+
+/**
+ * @brief Counts records by TTL, bucket i holds TTLs from 2^(i-1) to 2^i - 1 (bucket 0 TTL 0)
+ * @return number of records in each bucket
+ */
+array<uint64_t, RESULTS_TTL_BUCKETS> ResultStore::ttlHistogram() const {
+    array<uint64_t, RESULTS_TTL_BUCKETS> buckets{};
+    const uint32_t* column = ttls.data();
+    for (size_t i = 0; i < ttls.size(); i++) {
+        buckets[bit_width(column[i])]++;
+    }
+    return buckets;
+}
+
+/**
+ * @brief Follows CNAME records from each alias that is not target of another CNAME to its canonical name,
+ * names of a loop without such alias are reported once as loop
+ * @return chains in order in which their aliases were stored
+ */
+vector<CnameChain> ResultStore::cnameChains() const {
+    const size_t names = getNames();
+    // CNAME record of each name and id of its target (RESULTS_NO_NAME when target owns no record)
+    vector<size_t> cname(names, SIZE_MAX);
+    vector<uint32_t> target(names, RESULTS_NO_NAME);
+    vector<bool> is_target(names, false);
+    string lowered;
+    const uint16_t* type_column = types.data();
+    for (size_t i = 0; i < getRecords(); i++) {
+        if (type_column[i] != RR_TYPE::CNAME) {
+            continue;
+        }
+        const uint32_t owner = owners[i];
+        if (cname[owner] != SIZE_MAX) {
+            continue;
+        }
+        cname[owner] = i;
+        target[owner] = find(lower_name(rdata(i), lowered));
+        if (target[owner] != RESULTS_NO_NAME) {
+            is_target[target[owner]] = true;
+        }
+    }
+
+    vector<CnameChain> chains;
+    vector<bool> visited(names, false);
+    const auto follow = [&](const uint32_t alias) {
+        CnameChain chain;
+        chain.alias = string(name(alias));
+        uint32_t current = alias;
+        while (true) {
+            visited[current] = true;
+            chain.length++;
+            const uint32_t next = target[current];
+            if (next == RESULTS_NO_NAME) {
+                chain.canonical = lower_name(rdata(cname[current]), lowered);
+                break;
+            }
+            if (cname[next] == SIZE_MAX) {
+                chain.canonical = string(name(next));
+                break;
+            }
+            if (next == alias || chain.length >= RESULTS_MAX_CHAIN) {
+                chain.canonical = string(name(next));
+                chain.loop = true;
+                break;
+            }
+            current = next;
+        }
+        chains.push_back(move(chain));
+    };
+    for (uint32_t id = 0; id < names; id++) {
+        if (cname[id] != SIZE_MAX && !is_target[id]) {
+            follow(id);
+        }
+    }
+    for (uint32_t id = 0; id < names; id++) {
+        if (cname[id] != SIZE_MAX && !visited[id]) {
+            follow(id);
+        }
+    }
+    return chains;
+}
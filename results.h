@@ -0,0 +1,194 @@
+/**
+ * @file results.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of compact columnar store of resolved records and its aggregations, part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dns.h"
+
+// memory of columns above which the store moves them to files of spill directory (when it has one)
+constexpr size_t RESULTS_SPILL_THRESHOLD = 256 << 20;
+// initial capacity of each column in bytes (one page), capacity doubles when column is full
+constexpr size_t RESULTS_INITIAL_CAPACITY = 4096;
+// CNAME chains longer than this are reported as loops
+constexpr size_t RESULTS_MAX_CHAIN = 16;
+// TTL histogram buckets: 0, 1, 2-3, 4-7, ..., 2^31 and more
+constexpr size_t RESULTS_TTL_BUCKETS = 33;
+// rows of the most common record data in summary
+constexpr size_t RESULTS_SUMMARY_GROUPS = 10;
+// name id of missing name
+constexpr uint32_t RESULTS_NO_NAME = UINT32_MAX;
+
+/**
+ * @brief Growable byte buffer in anonymous memory mapping, which can be moved to (unlinked) file of spill directory,
+ * then kernel writes its pages back to the file instead of keeping them in memory
+ */
+class MappedBuffer {
+public:
+    MappedBuffer() = default;
+    ~MappedBuffer();
+    MappedBuffer(const MappedBuffer&) = delete;
+    MappedBuffer& operator=(const MappedBuffer&) = delete;
+
+    bool append(const void* bytes, size_t length);
+    bool spill(const std::string& directory, std::string& error);
+
+    const uint8_t* data() const {
+        return memory;
+    }
+    size_t size() const {
+        return length;
+    }
+    size_t capacity() const {
+        return reserved;
+    }
+    bool isSpilled() const {
+        return fd != -1;
+    }
+
+private:
+    bool reserve(size_t bytes);
+
+    uint8_t* memory = nullptr;
+    size_t length = 0;
+    size_t reserved = 0;
+    // backing file after spill
+    int fd = -1;
+};
+
+/**
+ * @brief Column of trivially copyable values in mapped buffer
+ */
+template <class T>
+class Column {
+public:
+    bool push_back(const T& value) {
+        return buffer.append(&value, sizeof(T));
+    }
+    T operator[](const size_t index) const {
+        T value;
+        memcpy(&value, buffer.data() + index * sizeof(T), sizeof(T));
+        return value;
+    }
+    const T* data() const {
+        return reinterpret_cast<const T*>(buffer.data());
+    }
+    size_t size() const {
+        return buffer.size() / sizeof(T);
+    }
+    MappedBuffer& getBuffer() {
+        return buffer;
+    }
+    const MappedBuffer& getBuffer() const {
+        return buffer;
+    }
+
+private:
+    MappedBuffer buffer;
+};
+
+/**
+ * @brief Records sharing the same record data
+ */
+struct RdataGroup {
+    uint16_t type = 0;
+    std::string rdata;
+    size_t records = 0;
+    // distinct owner names
+    size_t owners = 0;
+};
+
+/**
+ * @brief Alias resolved through CNAME records of the store
+ */
+struct CnameChain {
+    std::string alias;
+    // last name of chain, target of the last CNAME
+    std::string canonical;
+    size_t length = 0;
+    // chain returns to its name or is longer than RESULTS_MAX_CHAIN
+    bool loop = false;
+};
+
+/**
+ * @brief Answer records of many responses in struct-of-arrays layout: owner names are interned (each distinct name
+ * is stored once, lower case with trailing dot) and records are rows of flat columns (owner id, type, class, TTL,
+ * offset and length of record data, index of query), record data are appended as text to one byte arena.
+ * One record takes about 26 bytes plus its data instead of a parsed packet with its own copies of names.
+ * Aggregations scan only the columns they need. All columns can spill to memory mapped files
+ */
+class ResultStore {
+public:
+    explicit ResultStore(std::string spill_directory = "", size_t spill_threshold = RESULTS_SPILL_THRESHOLD);
+
+    bool add(uint32_t query, const DNSPacket& response);
+
+    std::vector<RdataGroup> groupByRdata(size_t limit) const;
+    std::array<uint64_t, RESULTS_TTL_BUCKETS> ttlHistogram() const;
+    std::vector<CnameChain> cnameChains() const;
+
+    std::string_view name(uint32_t id) const;
+    std::string_view rdata(size_t record) const;
+
+    size_t getRecords() const {
+        return owners.size();
+    }
+    size_t getNames() const {
+        return name_offsets.size();
+    }
+    size_t getResponses() const {
+        return responses;
+    }
+    size_t getMemory() const;
+    bool isSpilled() const {
+        return spilled;
+    }
+    const std::string& getError() const {
+        return error;
+    }
+
+private:
+    uint32_t intern(std::string_view name);
+    uint32_t find(std::string_view name) const;
+    static uint64_t nameHash(std::string_view name);
+    bool growIndex();
+    bool spillColumns();
+
+    std::string spill_directory;
+    size_t spill_threshold;
+    bool spilled = false;
+    size_t responses = 0;
+    std::string error;
+    // buffers reused by add, so records are stored without allocation
+    std::string scratch_name;
+    std::string scratch_rdata;
+
+    // interned names: characters and start of each name, end of name is start of the next one
+    MappedBuffer name_bytes;
+    Column<uint64_t> name_offsets;
+    // open addressing index of names by hash (ids, RESULTS_NO_NAME when empty), in memory, size power of two
+    std::vector<uint32_t> name_index;
+
+    // one row per record
+    Column<uint32_t> owners;
+    Column<uint16_t> types;
+    Column<uint16_t> classes;
+    Column<uint32_t> ttls;
+    Column<uint64_t> rdata_offsets;
+    Column<uint16_t> rdata_lengths;
+    Column<uint32_t> queries;
+    MappedBuffer rdata_bytes;
+};
+
+#endif // RESULTS_H
@@ -0,0 +1,230 @@
+/**
+ * @file stats.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of per-stage timing counters and histograms of dns resolver
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "stats.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <string>
+
+using namespace std;
+
+static StageHistogram stage_histograms[static_cast<int>(Stage::Count)];
+static atomic<uint64_t> counters[static_cast<int>(Counter::Count)]{};
+static chrono::steady_clock::time_point stats_start;
+// depth of queue after each push, waits of producer on full queue and of consumer on empty queue
+static StageHistogram queue_depths[static_cast<int>(Queue::Count)];
+static atomic<uint64_t> queue_full_waits[static_cast<int>(Queue::Count)]{};
+static atomic<uint64_t> queue_empty_waits[static_cast<int>(Queue::Count)]{};
+
+static const char* stage_names[] = {"init", "encode", "send", "wait", "parse", "print", "rtt"};
+static const char* queue_names[] = {"parse", "output"};
+
+/**
+ * @brief Returns name of stage used in reports and traces
+ * @param stage measured stage
+ * @return name of stage
+ */
+const char* stats_stage_name(const Stage stage) {
+    return stage_names[static_cast<int>(stage)];
+}
+
+/**
+ * @brief Computes bucket of value, values below 2^STATS_SUB_BITS have own buckets
+ * @param value recorded value
+ * @return index of bucket
+ */
+static int bucket_index(const uint64_t value) {
+    if (value < (uint64_t{1} << STATS_SUB_BITS)) {
+        return static_cast<int>(value);
+    }
+    const int exponent = 63 - __builtin_clzll(value);
+    const int shift = exponent - STATS_SUB_BITS;
+    const int sub = static_cast<int>((value >> shift) & ((1 << STATS_SUB_BITS) - 1));
+    return ((shift + 1) << STATS_SUB_BITS) + sub;
+}
+
+/**
+ * @brief Computes upper bound of values stored in bucket
+ * @param index index of bucket
+ * @return largest value of bucket
+ */
+static uint64_t bucket_upper(const int index) {
+    if (index < (1 << STATS_SUB_BITS)) {
+        return static_cast<uint64_t>(index);
+    }
+    const int shift = (index >> STATS_SUB_BITS) - 1;
+    const uint64_t sub = static_cast<uint64_t>(index & ((1 << STATS_SUB_BITS) - 1));
+    return (((uint64_t{1} << STATS_SUB_BITS) | sub) << shift) + ((uint64_t{1} << shift) - 1);
+}
+
+/**
+ * @brief Records one duration
+ * @param ns duration in nanoseconds
+ */
+void StageHistogram::record(const uint64_t ns) {
+    count.fetch_add(1, memory_order_relaxed);
+    total.fetch_add(ns, memory_order_relaxed);
+    buckets[bucket_index(ns)].fetch_add(1, memory_order_relaxed);
+    uint64_t current = max.load(memory_order_relaxed);
+    while (ns > current && !max.compare_exchange_weak(current, ns, memory_order_relaxed)) {}
+}
+
+/**
+ * @brief Estimates percentile from histogram buckets
+ * @param fraction percentile in range (0 - 1)
+ * @return upper bound of bucket containing the percentile
+ */
+uint64_t StageHistogram::percentile(const double fraction) const {
+    const uint64_t total_count = getCount();
+    if (total_count == 0) {
+        return 0;
+    }
+    const auto rank = static_cast<uint64_t>(fraction * static_cast<double>(total_count - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < STATS_BUCKETS; i++) {
+        seen += buckets[i].load(memory_order_relaxed);
+        if (seen >= rank) {
+            return min(bucket_upper(i), getMax());
+        }
+    }
+    return getMax();
+}
+
+/**
+ * @brief Print statistics to stderr, program registers it to run at exit (also on error exit)
+ */
+void stats_report() {
+    stats_print(cerr);
+}
+
+/**
+ * @brief Enables statistics, they are collected until caller prints them by stats_print or stats_report
+ */
+void stats_enable() {
+    if (stats_enabled) {
+        return;
+    }
+    stats_enabled = true;
+    stats_start = chrono::steady_clock::now();
+}
+
+/**
+ * @brief Records duration of stage
+ * @param stage measured stage
+ * @param ns duration in nanoseconds
+ */
+void stats_record(const Stage stage, const uint64_t ns) {
+    stage_histograms[static_cast<int>(stage)].record(ns);
+}
+
+/**
+ * @brief Adds value to counter when statistics are enabled
+ * @param counter counter to increase
+ * @param value value to add
+ */
+void stats_count(const Counter counter, const uint64_t value) {
+    if (stats_enabled) {
+        counters[static_cast<int>(counter)].fetch_add(value, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Records number of items in queue after producer added one, when statistics are enabled
+ * @param queue measured queue
+ * @param depth items waiting for consumer
+ */
+void stats_queue_depth(const Queue queue, const uint64_t depth) {
+    if (stats_enabled) {
+        queue_depths[static_cast<int>(queue)].record(depth);
+    }
+}
+
+/**
+ * @brief Counts wait of stage on queue when statistics are enabled, full queue stalls producer
+ * (consumer is the bottleneck), empty queue idles consumer (producer is the bottleneck)
+ * @param queue queue stage waits on
+ * @param full producer waits for free slot, otherwise consumer waits for item
+ */
+void stats_queue_wait(const Queue queue, const bool full) {
+    if (stats_enabled) {
+        (full ? queue_full_waits : queue_empty_waits)[static_cast<int>(queue)].fetch_add(1, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Prints per-stage totals, means and percentiles and transfer counters
+ * @param out output stream
+ */
+void stats_print(ostream& out) {
+    const double run_ms = static_cast<double>(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - stats_start).count()) / 1e3;
+    auto counter = [](const Counter c) {
+        return counters[static_cast<int>(c)].load(memory_order_relaxed);
+    };
+
+    out << "Statistics (run time " << fixed << setprecision(3) << run_ms << " ms)" << endl;
+    out << "  " << setw(10) << left << "stage" << right << setw(10) << "count" << setw(13) << "total ms"
+        << setw(11) << "mean us" << setw(11) << "p50 us" << setw(11) << "p90 us"
+        << setw(11) << "p99 us" << setw(11) << "max us" << endl;
+
+    double cpu_ms = 0;
+    for (int i = 0; i < static_cast<int>(Stage::Count); i++) {
+        const StageHistogram& histogram = stage_histograms[i];
+        const uint64_t count = histogram.getCount();
+        const double total_ms = static_cast<double>(histogram.getTotal()) / 1e6;
+        if (static_cast<Stage>(i) == Stage::Rtt && count == 0) {
+            continue;
+        }
+        if (static_cast<Stage>(i) != Stage::Wait && static_cast<Stage>(i) != Stage::Rtt) {
+            cpu_ms += total_ms;
+        }
+        out << "  " << setw(10) << left << stage_names[i] << right << setw(10) << count
+            << setw(13) << setprecision(3) << total_ms
+            << setw(11) << setprecision(1) << (count > 0 ? static_cast<double>(histogram.getTotal()) / static_cast<double>(count) / 1e3 : 0.0)
+            << setw(11) << static_cast<double>(histogram.percentile(0.50)) / 1e3
+            << setw(11) << static_cast<double>(histogram.percentile(0.90)) / 1e3
+            << setw(11) << static_cast<double>(histogram.percentile(0.99)) / 1e3
+            << setw(11) << static_cast<double>(histogram.getMax()) / 1e3 << endl;
+    }
+
+    const double wait_ms = static_cast<double>(stage_histograms[static_cast<int>(Stage::Wait)].getTotal()) / 1e6;
+    out << "  Queries: " << counter(Counter::Queries) << ", responses: " << counter(Counter::Responses)
+        << ", retransmits: " << counter(Counter::Retransmits) << ", timeouts: " << counter(Counter::Timeouts) << endl;
+    out << "  Bytes sent: " << counter(Counter::BytesSent) << ", received: " << counter(Counter::BytesReceived) << endl;
+    out << "  Send fails: " << counter(Counter::SendFails) << ", receive fails: " << counter(Counter::RecvFails)
+        << ", backoffs: " << counter(Counter::Backoffs) << endl;
+    if (counter(Counter::CacheHits) + counter(Counter::CacheMisses) > 0) {
+        out << "  Cache hits: " << counter(Counter::CacheHits) << ", misses: " << counter(Counter::CacheMisses)
+            << ", prefetches: " << counter(Counter::CachePrefetches)
+            << ", rejected (backlog or waiting clients full): " << counter(Counter::ForwardRejects) << endl;
+    }
+    if (counter(Counter::NegativeSkips) + counter(Counter::NegativeFalsePositives) > 0) {
+        out << "  Known nonexistent names skipped: " << counter(Counter::NegativeSkips)
+            << ", false positives of filter: " << counter(Counter::NegativeFalsePositives) << endl;
+    }
+    if (queue_depths[static_cast<int>(Queue::Parse)].getCount() > 0) {
+        out << "  " << setw(10) << left << "queue" << right << setw(10) << "items" << setw(11) << "mean"
+            << setw(11) << "p50" << setw(11) << "p99" << setw(11) << "max" << setw(12) << "full waits"
+            << setw(13) << "empty waits" << endl;
+        for (int i = 0; i < static_cast<int>(Queue::Count); i++) {
+            const StageHistogram& histogram = queue_depths[i];
+            const uint64_t count = histogram.getCount();
+            out << "  " << setw(10) << left << queue_names[i] << right << setw(10) << count
+                << setw(11) << setprecision(1) << (count > 0 ? static_cast<double>(histogram.getTotal()) / static_cast<double>(count) : 0.0)
+                << setw(11) << histogram.percentile(0.50) << setw(11) << histogram.percentile(0.99)
+                << setw(11) << histogram.getMax() << setw(12) << queue_full_waits[i].load(memory_order_relaxed)
+                << setw(13) << queue_empty_waits[i].load(memory_order_relaxed) << endl;
+        }
+    }
+    // stages of pipeline run in parallel threads, so their sum is time spent by all threads, not a share of run time
+    if (run_ms > 0) {
+        out << "  Waiting for network: " << setprecision(1) << 100 * wait_ms / run_ms << " % of run time, "
+            << "processing: " << setprecision(3) << cpu_ms << " ms summed over all threads" << endl;
+    }
+    out << defaultfloat;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file stats.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of per-stage timing counters and histograms of dns resolver
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#include "trace.h"
+
+enum class Stage {
+    Init,
+    Encode,
+    Send,
+    Wait,
+    Parse,
+    Print,
+    // round trip time of query from send syscall to receipt of response, not time spent by program
+    Rtt,
+    Count
+};
+
+enum class Counter {
+    BytesSent,
+    BytesReceived,
+    Queries,
+    Responses,
+    SendFails,
+    RecvFails,
+    Retransmits,
+    Timeouts,
+    CacheHits,
+    CacheMisses,
+    CachePrefetches,
+    ForwardRejects,
+    Backoffs,
+    NegativeSkips,
+    NegativeFalsePositives,
+    Count
+};
+
+// queues between stages of bulk pipeline (--pipeline), named by the stage they feed
+enum class Queue {
+    Parse,
+    Output,
+    Count
+};
+
+// histogram buckets are log-linear, every power of two is split into 2^STATS_SUB_BITS buckets (max error 12.5 %)
+constexpr int STATS_SUB_BITS = 3;
+constexpr int STATS_BUCKETS = (65 - STATS_SUB_BITS) << STATS_SUB_BITS;
+
+/**
+ * @brief Lock-free histogram of stage durations in nanoseconds
+ */
+class StageHistogram {
+public:
+    void record(uint64_t ns);
+    uint64_t percentile(double fraction) const;
+
+    uint64_t getCount() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getTotal() const {
+        return total.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getMax() const {
+        return max.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> max{0};
+    std::atomic<uint64_t> buckets[STATS_BUCKETS]{};
+};
+
+inline bool stats_enabled = false;
+
+void stats_enable();
+void stats_record(Stage stage, uint64_t ns);
+void stats_count(Counter counter, uint64_t value = 1);
+void stats_print(std::ostream& out);
+void stats_report();
+const char* stats_stage_name(Stage stage);
+void stats_queue_depth(Queue queue, uint64_t depth);
+void stats_queue_wait(Queue queue, bool full);
+
+/**
+ * @brief Measures duration of scope, records it to stage histogram when statistics are enabled
+ * and as span of query when tracing is enabled
+ */
+class StageTimer {
+public:
+    explicit StageTimer(const Stage stage, const uint64_t query = 0, const uint32_t attempt = 0) : stage(stage), query(query), attempt(attempt) {
+        if (stats_enabled || trace_enabled) {
+            start = trace_now();
+        }
+    }
+
+    ~StageTimer() {
+        stop();
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+    void stop() {
+        if (!stopped && (stats_enabled || trace_enabled)) {
+            const uint64_t end = trace_now();
+            if (stats_enabled) {
+                stats_record(stage, end - start);
+            }
+            if (trace_enabled) {
+                trace_complete(stats_stage_name(stage), query, attempt, start, end);
+            }
+        }
+        stopped = true;
+    }
+
+    uint64_t getStart() const {
+        return start;
+    }
+
+private:
+    Stage stage;
+    uint64_t query;
+    uint32_t attempt;
+    bool stopped = false;
+    uint64_t start = 0;
+};
+
+#endif // STATS_H
@@ -0,0 +1,149 @@
+/**
+ * @file sweep.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of reverse lookup sweep over CIDR address range
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "sweep.h"
+
+#include <cstdlib>
+
+#if defined(_WIN32) || defined(_WIN64) // windows
+#include <ws2tcpip.h>
+#else // unix
+#include <arpa/inet.h>
+#endif // _WIN32 || _WIN64
+
+using namespace std;
+
+/**
+ * @brief Converts nibble to lowercase hexadecimal digit
+ * @param nibble value 0-15
+ * @return hexadecimal digit
+ */
+static char hex_digit(const uint8_t nibble) {
+    return static_cast<char>(nibble > 9 ? 'a' + nibble - 10 : '0' + nibble);
+}
+
+/**
+ * @brief Parses range in CIDR notation (e.g. 10.0.0.0/16 or 2001:db8::/64), host bits of address are cleared
+ * @param range address range
+ * @return true if range is valid
+ */
+bool ReverseSweep::parse(const string& range) {
+    const size_t slash = range.find('/');
+    if (slash == string::npos || slash + 1 == range.length()) {
+        return false;
+    }
+
+    char* endptr;
+    const long prefix = strtol(range.c_str() + slash + 1, &endptr, 10);
+    const string network = range.substr(0, slash);
+
+    int bits;
+    if (inet_pton(AF_INET, network.c_str(), address) == 1) {
+        ipv6 = false;
+        bits = 32;
+    } else if (inet_pton(AF_INET6, network.c_str(), address) == 1) {
+        ipv6 = true;
+        bits = 128;
+    } else {
+        return false;
+    }
+    if (*endptr != '\0' || prefix < 0 || prefix > bits) {
+        return false;
+    }
+
+    // Clear host bits
+    for (int i = 0; i < bits / 8; i++) {
+        const long keep = prefix - i * 8;
+        if (keep <= 0) {
+            address[i] = 0;
+        } else if (keep < 8) {
+            address[i] &= static_cast<uint8_t>(0xff << (8 - keep));
+        }
+    }
+
+    const long host_bits = bits - prefix;
+    truncated = host_bits >= 64 || (uint64_t{1} << host_bits) > MAX_SWEEP_ADDRESSES;
+    count = truncated ? MAX_SWEEP_ADDRESSES : uint64_t{1} << host_bits;
+    generated = 0;
+
+    if (ipv6) {
+        name6.clear();
+        for (int i = 15; i >= 0; --i) {
+            name6 += hex_digit(address[i] & 0xf);
+            name6 += '.';
+            name6 += hex_digit(address[i] >> 4);
+            name6 += '.';
+        }
+        name6 += "ip6.arpa";
+    } else {
+        suffix.clear();
+        for (int i = 2; i >= 0; --i) {
+            suffix += to_string(address[i]);
+            suffix += '.';
+        }
+        suffix += "in-addr.arpa";
+    }
+
+    return true;
+}
+
+/**
+ * @brief Moves to next address, labels of changed octets (nibbles) are updated
+ */
+void ReverseSweep::increment() {
+    if (ipv6) {
+        // Nibble n (from the lowest) is stored at position 2 * n of the name
+        for (int i = 15; i >= 0; --i) {
+            address[i]++;
+            name6[(15 - i) * 4] = hex_digit(address[i] & 0xf);
+            if ((address[i] & 0xf) != 0) {
+                return;
+            }
+            name6[(15 - i) * 4 + 2] = hex_digit(address[i] >> 4);
+            if (address[i] != 0) {
+                return;
+            }
+        }
+        return;
+    }
+
+    if (++address[3] != 0) {
+        return;
+    }
+    // Lowest octet overflowed, rebuild labels of upper octets
+    for (int i = 2; i >= 0 && ++address[i] == 0; --i) {}
+    suffix.clear();
+    for (int i = 2; i >= 0; --i) {
+        suffix += to_string(address[i]);
+        suffix += '.';
+    }
+    suffix += "in-addr.arpa";
+}
+
+/**
+ * @brief Generates reverse name of next address in range
+ * @param name output name
+ * @return false when all addresses were generated
+ */
+bool ReverseSweep::next(string& name) {
+    if (generated == count) {
+        return false;
+    }
+    if (generated++ > 0) {
+        increment();
+    }
+
+    if (ipv6) {
+        name = name6;
+    } else {
+        name = to_string(address[3]);
+        name += '.';
+        name += suffix;
+    }
+    return true;
+}
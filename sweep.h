@@ -0,0 +1,56 @@
+/**
+ * @file sweep.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of reverse lookup sweep over CIDR address range
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <string>
+#include <cstdint>
+
+// maximum number of addresses generated from one range (IPv4 /16 or sample of larger IPv6 block)
+constexpr uint64_t MAX_SWEEP_ADDRESSES = 65536;
+
+/**
+ * @brief Generator of in-addr.arpa / ip6.arpa names for all addresses of CIDR range.
+ * Names are built incrementally, only labels of octets (nibbles) changed by increment are rewritten.
+ */
+class ReverseSweep {
+public:
+    ReverseSweep() = default;
+
+    bool parse(const std::string& range);
+    bool next(std::string& name);
+
+    uint64_t getCount() const {
+        return count;
+    }
+
+    bool isTruncated() const {
+        return truncated;
+    }
+
+    static bool isRange(const std::string& address) {
+        return address.find('/') != std::string::npos;
+    }
+
+private:
+    void increment();
+
+    bool ipv6 = false;
+    uint8_t address[16] = {};
+    uint64_t count = 0;
+    uint64_t generated = 0;
+    bool truncated = false;
+
+    // IPv4: labels of three upper octets with suffix, rebuilt only when lowest octet overflows
+    std::string suffix;
+    // IPv6: whole name, nibbles are rewritten in place
+    std::string name6;
+};
+
+#endif // SWEEP_H
@@ -14,6 +14,49 @@ for address in $addresses; do
     done
 done
 
+# zone transfers against scripted server on loopback (transfer_server.py)
+failed=0
+check() {
+    # check NAME EXPECTED OUTPUT: OUTPUT has to contain line starting with EXPECTED
+    if printf '%s\n' "$3" | grep -q "^$2"; then
+        echo "PASS $1"
+    else
+        echo "FAIL $1: expected '$2'"
+        printf '%s\n' "$3" | tail -n 3
+        failed=1
+    fi
+}
+
+port_file=$(mktemp)
+python3 ./transfer_server.py > "$port_file" &
+server_pid=$!
+while [ ! -s "$port_file" ] && kill -0 "$server_pid" 2>/dev/null; do
+    sleep 0.1
+done
+port=$(head -n 1 "$port_file")
+rm -f "$port_file"
+
+output=$(./dns -s 127.0.0.1 -p "$port" -t AXFR transfer.test 2>&1)
+check "AXFR in several messages" "Transfer complete: 252 records in 3 messages" "$output"
+check "AXFR has two SOAs" "2" "$(printf '%s\n' "$output" | grep -c ' SOA ')"
+output=$(./dns -s 127.0.0.1 -p "$port" -t IXFR=4 transfer.test 2>&1)
+check "IXFR with changes" "Transfer complete: 6 records in 2 messages" "$output"
+check "IXFR with changes has three SOAs of serial 5" "3" "$(printf '%s\n' "$output" | grep -c ' SOA .* 5 7200 ')"
+output=$(./dns -s 127.0.0.1 -p "$port" -t IXFR=5 transfer.test 2>&1)
+check "IXFR of up to date zone" "Zone is up to date, serial 5" "$output"
+check "IXFR of up to date zone is single SOA" "Transfer complete: 1 records in 1 messages" "$output"
+# one record per message, lone SOA at start of stream is not an up to date answer
+output=$(./dns -s 127.0.0.1 -p "$port" -t IXFR=4 single.transfer.test 2>&1)
+check "IXFR with changes, one record per message" "Transfer complete: 6 records in 6 messages" "$output"
+output=$(./dns -s 127.0.0.1 -p "$port" -t AXFR single.transfer.test 2>&1)
+check "AXFR, one record per message" "Transfer complete: 252 records in 252 messages" "$output"
+output=$(./dns -s 127.0.0.1 -p "$port" -t IXFR=5 single.transfer.test 2>&1)
+check "IXFR of up to date zone, one record per message" "Zone is up to date, serial 5" "$output"
+
+kill "$server_pid" 2>/dev/null
+wait "$server_pid" 2>/dev/null
+exit $failed
+
 #Test:
 #-r -6 -s 8.8.8.8 2607:f8b0:4003:c00::6a
 #-r -s kazi.fit.vutbr.cz www.fit.vut.cz
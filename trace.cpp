@@ -0,0 +1,205 @@
+/**
+ * @file trace.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of per-query tracing in Chrome trace-event format
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "trace.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/**
+ * @brief One trace event, name points to string literal
+ */
+struct TraceEvent {
+    const char* name;
+    uint64_t ts;
+    uint64_t dur;
+    uint64_t query;
+    uint32_t attempt;
+    char phase;
+};
+
+/**
+ * @brief Ring buffer of events of one thread, written only by its thread and read after the run
+ */
+struct TraceBuffer {
+    explicit TraceBuffer(const int tid) : tid(tid), events(new TraceEvent[TRACE_BUFFER_EVENTS]) {}
+
+    void push(const TraceEvent& event) {
+        events[written % TRACE_BUFFER_EVENTS] = event;
+        written++;
+    }
+
+    int tid;
+    unique_ptr<TraceEvent[]> events;
+    uint64_t written = 0;
+};
+
+static string trace_file;
+static mutex trace_buffers_mutex;
+static vector<unique_ptr<TraceBuffer>> trace_buffers;
+static uint64_t trace_start = 0;
+
+/**
+ * @brief Returns buffer of calling thread, buffer is registered on first use (the only locked operation)
+ * @return buffer of calling thread
+ */
+static TraceBuffer& trace_buffer() {
+    thread_local TraceBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+        lock_guard<mutex> lock(trace_buffers_mutex);
+        trace_buffers.push_back(make_unique<TraceBuffer>(static_cast<int>(trace_buffers.size()) + 1));
+        buffer = trace_buffers.back().get();
+    }
+    return *buffer;
+}
+
+/**
+ * @brief Enables tracing, events are collected until caller writes them to file by trace_flush
+ * @param file output file
+ * @return false if file cannot be created
+ */
+bool trace_enable(const string& file) {
+    if (!ofstream(file).is_open()) {
+        return false;
+    }
+    trace_file = file;
+    trace_start = trace_now();
+    trace_enabled = true;
+    return true;
+}
+
+/**
+ * @brief Records complete event (span) of query stage
+ * @param name name of stage
+ * @param query query sequence number (starting with 1), 0 when event does not belong to query
+ * @param attempt number of transmission, 0 when not applicable
+ * @param start_ns start of span
+ * @param end_ns end of span
+ */
+void trace_complete(const char* name, const uint64_t query, const uint32_t attempt, const uint64_t start_ns, const uint64_t end_ns) {
+    if (trace_enabled) {
+        trace_buffer().push({name, start_ns, end_ns - start_ns, query, attempt, 'X'});
+    }
+}
+
+/**
+ * @brief Records begin ('b') or end ('e') of asynchronous span of query
+ * @param phase 'b' or 'e'
+ * @param name name of span
+ * @param query query sequence number
+ * @param ts_ns timestamp
+ */
+void trace_async(const char phase, const char* name, const uint64_t query, const uint64_t ts_ns) {
+    if (trace_enabled) {
+        trace_buffer().push({name, ts_ns, 0, query, 0, phase});
+    }
+}
+
+/**
+ * @brief Records flow event linking transmissions of query: start ('s'), step ('t') or finish ('f')
+ * @param phase 's', 't' or 'f'
+ * @param query query sequence number
+ * @param ts_ns timestamp inside of the span the flow binds to
+ */
+void trace_flow(const char phase, const uint64_t query, const uint64_t ts_ns) {
+    if (trace_enabled) {
+        trace_buffer().push({"transmissions", ts_ns, 0, query, 0, phase});
+    }
+}
+
+/**
+ * @brief Appends timestamp relative to trace start in microseconds
+ * @param out output string
+ * @param ns timestamp in nanoseconds
+ */
+static void append_us(string& out, const uint64_t ns) {
+    out += to_string(ns / 1000);
+    out += '.';
+    const string fraction = to_string(ns % 1000);
+    out.append(3 - fraction.length(), '0');
+    out += fraction;
+}
+
+/**
+ * @brief Writes all recorded events to trace file as Chrome trace-event JSON
+ */
+void trace_flush() {
+    if (!trace_enabled) {
+        return;
+    }
+    trace_enabled = false;
+
+    ofstream file(trace_file);
+    if (!file.is_open()) {
+        return;
+    }
+
+#if defined(_WIN32) || defined(_WIN64)
+    const string pid = "1";
+#else
+    const string pid = to_string(getpid());
+#endif
+
+    lock_guard<mutex> lock(trace_buffers_mutex);
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    file << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << pid << ",\"args\":{\"name\":\"dns\"}}";
+
+    string line;
+    for (const auto& buffer : trace_buffers) {
+        file << ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid << ",\"tid\":" << buffer->tid
+             << ",\"args\":{\"name\":\"thread " << buffer->tid << "\"}}";
+        if (buffer->written > TRACE_BUFFER_EVENTS) {
+            file << ",\n{\"ph\":\"i\",\"s\":\"t\",\"name\":\"dropped " << buffer->written - TRACE_BUFFER_EVENTS
+                 << " oldest events\",\"pid\":" << pid << ",\"tid\":" << buffer->tid << ",\"ts\":0}";
+        }
+
+        const uint64_t first = buffer->written > TRACE_BUFFER_EVENTS ? buffer->written - TRACE_BUFFER_EVENTS : 0;
+        for (uint64_t i = first; i < buffer->written; i++) {
+            const TraceEvent& event = buffer->events[i % TRACE_BUFFER_EVENTS];
+            line = ",\n{\"ph\":\"";
+            line += event.phase;
+            line += "\",\"name\":\"";
+            line += event.name;
+            line += "\",\"cat\":\"dns\",\"pid\":" + pid + ",\"tid\":" + to_string(buffer->tid) + ",\"ts\":";
+            append_us(line, event.ts > trace_start ? event.ts - trace_start : 0);
+            if (event.phase == 'X') {
+                line += ",\"dur\":";
+                append_us(line, event.dur);
+            } else {
+                // async and flow events are matched by id
+                line += ",\"id\":" + to_string(event.query);
+                if (event.phase == 's' || event.phase == 't' || event.phase == 'f') {
+                    line += ",\"bp\":\"e\"";
+                }
+            }
+            if (event.query != 0) {
+                const uint64_t scope = event.query >> TRACE_SCOPE_SHIFT;
+                line += ",\"args\":{\"query\":" + to_string(event.query & ((uint64_t{1} << TRACE_SCOPE_SHIFT) - 1));
+                if (scope != 0) {
+                    line += ",\"scope\":" + to_string(scope);
+                }
+                if (event.attempt != 0) {
+                    line += ",\"attempt\":" + to_string(event.attempt);
+                }
+                line += "}";
+            }
+            line += "}";
+            file << line;
+        }
+    }
+    file << "\n]}\n";
+}
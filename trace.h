@@ -0,0 +1,38 @@
+/**
+ * @file trace.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of per-query tracing in Chrome trace-event format
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// number of events kept per thread, oldest events are overwritten when the buffer is full
+constexpr size_t TRACE_BUFFER_EVENTS = 1 << 18;
+
+// query number of event is scope (e.g. compared server) in upper bits and sequence number of query in lower bits,
+// id of async and flow events is the whole number, arguments of event show both parts
+constexpr int TRACE_SCOPE_SHIFT = 32;
+
+inline bool trace_enabled = false;
+
+/**
+ * @brief Current time of steady clock in nanoseconds, used as timestamp of trace events
+ */
+inline uint64_t trace_now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool trace_enable(const std::string& file);
+void trace_complete(const char* name, uint64_t query, uint32_t attempt, uint64_t start_ns, uint64_t end_ns);
+void trace_async(char phase, const char* name, uint64_t query, uint64_t ts_ns);
+void trace_flow(char phase, uint64_t query, uint64_t ts_ns);
+void trace_flush();
+
+#endif // TRACE_H
@@ -0,0 +1,307 @@
+/**
+ * @file transfer.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of streaming zone transfer (AXFR and IXFR over TCP), part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "transfer.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include "stats.h"
+
+using namespace std;
+
+/**
+ * @brief Reads serial of SOA record
+ * @param record SOA record
+ * @param serial output serial
+ * @return false when record data are too short
+ */
+static bool soa_serial(const DNSRecord& record, uint32_t& serial) {
+    WireReader reader(record.getRdataBytes(), record.getRdlength());
+    reader.skipName();
+    reader.skipName();
+    const WireSoa* fields = reader.view<WireSoa>();
+    if (fields == nullptr) {
+        return false;
+    }
+    serial = fields->serial;
+    return true;
+}
+
+/**
+ * @brief Compares serials in sequence space arithmetic (RFC 1982), serials wrap around
+ * @param serial compared serial
+ * @param other serial compared to
+ * @return true when serial is newer than other
+ */
+static bool serial_newer(const uint32_t serial, const uint32_t other) {
+    return serial != other && static_cast<int32_t>(serial - other) > 0;
+}
+
+/**
+ * @brief Resolve server address and connect TCP socket to it
+ * @param host IP address or hostname of server
+ * @param port port of server
+ * @return Ok, ServerError (details in getError) or SocketError
+ */
+ResolverStatus ZoneTransfer::open(const string& host, const uint16_t port) {
+    StageTimer init_timer(Stage::Init);
+    disconnect();
+
+    vector<ServerAddress> addresses;
+    if (!server_address_lookup(host, port, addresses, error)) {
+        return ResolverStatus::ServerError;
+    }
+    for (const auto& address : addresses) {
+        const auto* ai_addr = reinterpret_cast<const sockaddr*>(&address.address);
+        if (ai_addr->sa_family != AF_INET && ai_addr->sa_family != AF_INET6) {
+            continue;
+        }
+        if ((socket_fd = socket(ai_addr->sa_family, SOCK_STREAM, 0)) == -1) {
+            continue;
+        }
+        if (connect(socket_fd, ai_addr, address.length) == -1) {
+            close(socket_fd);
+            socket_fd = -1;
+            continue;
+        }
+        return ResolverStatus::Ok;
+    }
+
+    error = "no address of server accepts TCP connection";
+    return ResolverStatus::SocketError;
+}
+
+/**
+ * @brief Close the connection
+ */
+void ZoneTransfer::disconnect() {
+    if (socket_fd != -1) {
+        close(socket_fd);
+        socket_fd = -1;
+    }
+}
+
+/**
+ * @brief Sends length prefixed query, IXFR query carries SOA with serial of zone copy in authority section (RFC 1995)
+ * @param zone name of zone
+ * @param type AXFR or IXFR
+ * @param serial serial of zone copy for IXFR
+ * @return Ok or SendError
+ */
+ResolverStatus ZoneTransfer::sendQuery(const string& zone, const RR_TYPE type, const uint32_t serial) {
+    StageTimer encode_timer(Stage::Encode, 1);
+    id = static_cast<uint16_t>(getpid() + reinterpret_cast<uintptr_t>(this));
+    string name = zone;
+    while (name.length() > 1 && name.back() == '.') {
+        name.pop_back();
+    }
+    const DNSPacket packet(DNSHeader(false, id), DNSQuestion(name == "." ? "" : name, static_cast<uint16_t>(type), 0x0001));
+    const unique_ptr<uint8_t[]> bytes = packet.getBytes();
+    // length prefix, query and SOA of IXFR (pointer to name of question, two empty names and SOA fields)
+    constexpr size_t SOA_SIZE = sizeof(uint16_t) + sizeof(WireRecord) + 2 + sizeof(WireSoa);
+    const bool ixfr_query = type == RR_TYPE::IXFR;
+    vector<uint8_t> query(sizeof(uint16_t) + packet.getSize() + (ixfr_query ? SOA_SIZE : 0));
+    WireWriter writer(query.data(), query.size());
+    writer.write(static_cast<uint16_t>(query.size() - sizeof(uint16_t)));
+    writer.writeBytes(bytes.get(), packet.getSize());
+    if (ixfr_query) {
+        reinterpret_cast<WireHeader*>(query.data() + sizeof(uint16_t))->nscount = 1;
+        writer.write(static_cast<uint16_t>(0xc000 | sizeof(WireHeader)));
+        WireRecord* record = writer.view<WireRecord>();
+        record->type = static_cast<uint16_t>(RR_TYPE::SOA);
+        record->class_ = 0x0001;
+        record->rdlength = 2 + sizeof(WireSoa);
+        writer.write(static_cast<uint16_t>(0));
+        writer.view<WireSoa>()->serial = serial;
+    }
+    encode_timer.stop();
+
+    StageTimer send_timer(Stage::Send, 1, 1);
+    size_t sent = 0;
+    int send_fails = 0;
+    while (sent < query.size()) {
+        const ssize_t result = ::send(socket_fd, reinterpret_cast<const char*>(query.data() + sent), query.size() - sent, 0);
+        if (result == -1) {
+            stats_count(Counter::SendFails);
+            if (errno != EINTR && ++send_fails >= MAX_TRANSFER_FAILS) {
+                return ResolverStatus::SendError;
+            }
+            continue;
+        }
+        sent += static_cast<size_t>(result);
+    }
+    stats_count(Counter::Queries);
+    stats_count(Counter::BytesSent, query.size());
+    return ResolverStatus::Ok;
+}
+
+/**
+ * @brief Parses one message of transfer and passes its answer records to handler
+ * @param message message without length prefix
+ * @param length length of message
+ * @param handle_record handler of records
+ * @param arena arena for parsed message, reset by caller
+ * @return Ok or ProtocolError (details in getError)
+ */
+ResolverStatus ZoneTransfer::handleMessage(const uint8_t* message, const size_t length, const RecordHandler& handle_record,
+                                           Arena& arena) {
+    StageTimer parse_timer(Stage::Parse, 1);
+    const DNSPacket packet(message, length, &arena);
+    parse_timer.stop();
+    if (packet.isMalformed()) {
+        error = "message " + to_string(summary.messages + 1) + " is malformed";
+        return ResolverStatus::ProtocolError;
+    }
+    const DNSHeader& header = packet.getHeader();
+    if (header.getId() != id) {
+        error = "ID of message " + to_string(summary.messages + 1) + " does not match ID of query";
+        return ResolverStatus::ProtocolError;
+    }
+    if (header.getRcode() != 0) {
+        error = "transfer failed with response code " + to_string(header.getRcode());
+        return ResolverStatus::ProtocolError;
+    }
+    summary.messages++;
+    stats_count(Counter::Responses);
+
+    const auto& answers = packet.getAnswers();
+    for (const auto& record : answers) {
+        const bool soa = record.getTypeValue() == RR_TYPE::SOA;
+        uint32_t serial = 0;
+        if (soa && !soa_serial(record, serial)) {
+            error = "SOA record of message " + to_string(summary.messages) + " is too short";
+            return ResolverStatus::ProtocolError;
+        }
+
+        if (summary.records == 0) {
+            if (!soa) {
+                error = "transfer does not start with SOA record";
+                return ResolverStatus::ProtocolError;
+            }
+            summary.serial = serial;
+            // IXFR answered by current SOA that is not newer than copy of client, zone did not change
+            // (shape of message does not tell it, server may send each record of transfer in its own message)
+            if (ixfr && !serial_newer(serial, requested_serial)) {
+                summary.records++;
+                handle_record(record);
+                summary.up_to_date = true;
+                done = true;
+                return ResolverStatus::Ok;
+            }
+        } else if (summary.records == 1 && ixfr && soa) {
+            incremental = true;
+        }
+        summary.records++;
+        handle_record(record);
+
+        if (soa && serial == summary.serial && ++soa_count == (incremental ? 3 : 2)) {
+            done = true;
+            return ResolverStatus::Ok;
+        }
+    }
+
+    return ResolverStatus::Ok;
+}
+
+/**
+ * @brief Requests zone transfer and reads stream of messages until the transfer is complete,
+ * complete messages are handled as soon as they are received and buffer is reused for next messages
+ * @param zone name of zone
+ * @param type AXFR or IXFR
+ * @param serial serial of zone copy for IXFR, ignored for AXFR
+ * @param handle_record handler of records in order of arrival
+ * @param timeout_ms maximum time to wait for next data of stream
+ * @return Ok, NotOpen, SendError, ReceiveError, Timeout or ProtocolError (details in getError)
+ */
+ResolverStatus ZoneTransfer::run(const string& zone, const RR_TYPE type, const uint32_t serial,
+                                 const RecordHandler& handle_record, const int timeout_ms) {
+    if (socket_fd == -1) {
+        return ResolverStatus::NotOpen;
+    }
+    summary = TransferSummary();
+    ixfr = type == RR_TYPE::IXFR;
+    requested_serial = serial;
+    soa_count = 0;
+    incremental = false;
+    done = false;
+
+    ResolverStatus status = sendQuery(zone, type, serial);
+    if (status != ResolverStatus::Ok) {
+        return status;
+    }
+
+    const unique_ptr<uint8_t[]> buffer(new uint8_t[TRANSFER_BUFFER_SIZE]);
+    size_t filled = 0;
+    // records of one message are parsed in arena, which is reset before next message
+    Arena arena;
+    int recv_fails = 0;
+    trace_async('b', "transfer", 1, trace_now());
+    while (true) {
+        // Handle all complete messages in buffer
+        size_t start = 0;
+        while (!done && filled - start >= 2) {
+            const size_t length = *reinterpret_cast<const BigEndian<uint16_t>*>(buffer.get() + start);
+            if (filled - start - 2 < length) {
+                break;
+            }
+            status = handleMessage(buffer.get() + start + 2, length, handle_record, arena);
+            arena.reset();
+            if (status != ResolverStatus::Ok) {
+                return status;
+            }
+            start += 2 + length;
+        }
+        if (done) {
+            break;
+        }
+        // Move incomplete message to start of buffer, there is always space for rest of it
+        memmove(buffer.get(), buffer.get() + start, filled - start);
+        filled -= start;
+
+        pollfd fds{};
+        fds.fd = socket_fd;
+        fds.events = POLLIN;
+        StageTimer wait_timer(Stage::Wait, 1);
+        const int ready = poll(&fds, 1, timeout_ms);
+        if (ready == 0) {
+            stats_count(Counter::Timeouts);
+            return ResolverStatus::Timeout;
+        }
+        // recv must not be reached without readable socket, it would block without timeout
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            stats_count(Counter::RecvFails);
+            error = string("waiting for transfer data failed: ") + strerror(errno);
+            return ResolverStatus::ReceiveError;
+        }
+        const ssize_t received = recv(socket_fd, reinterpret_cast<char*>(buffer.get() + filled), TRANSFER_BUFFER_SIZE - filled, 0);
+        wait_timer.stop();
+        if (received == 0) {
+            error = "connection closed before end of transfer";
+            return ResolverStatus::ProtocolError;
+        }
+        if (received == -1) {
+            if (errno != EINTR) {
+                stats_count(Counter::RecvFails);
+                if (++recv_fails >= MAX_TRANSFER_FAILS) {
+                    return ResolverStatus::ReceiveError;
+                }
+            }
+            continue;
+        }
+        recv_fails = 0;
+        filled += static_cast<size_t>(received);
+        summary.bytes += static_cast<uint64_t>(received);
+        stats_count(Counter::BytesReceived, static_cast<uint64_t>(received));
+    }
+    trace_async('e', "transfer", 1, trace_now());
+    return ResolverStatus::Ok;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file transfer.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of streaming zone transfer (AXFR and IXFR over TCP), part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef TRANSFER_H
+#define TRANSFER_H
+
+#include "resolver.h"
+
+// largest message of TCP stream, its length is prefixed by two bytes (RFC 1035 section 4.2.2)
+constexpr size_t MAX_TCP_MESSAGE = 0xffff;
+// receive buffer always fits one complete message after unprocessed data are moved to its start
+constexpr size_t TRANSFER_BUFFER_SIZE = 2 * (MAX_TCP_MESSAGE + 2);
+
+// called for each record of transfer in order of arrival, record points into message that is reused after the call
+using RecordHandler = function<void(const DNSRecord& record)>;
+
+/**
+ * @brief Counters of finished transfer
+ */
+struct TransferSummary {
+    size_t messages = 0;
+    size_t records = 0;
+    uint64_t bytes = 0;
+    // serial of SOA that starts the transfer (current serial of zone)
+    uint32_t serial = 0;
+    // IXFR answered by single SOA, zone did not change since requested serial
+    bool up_to_date = false;
+};
+
+/**
+ * @brief Zone transfer over TCP connection to server. Messages of the stream are parsed one at a time
+ * in arena that is reset after each message and records are passed to handler as they arrive,
+ * so memory does not grow with size of zone
+ */
+class ZoneTransfer {
+public:
+    ZoneTransfer() = default;
+    ~ZoneTransfer() {
+        disconnect();
+    }
+    ZoneTransfer(const ZoneTransfer&) = delete;
+    ZoneTransfer& operator=(const ZoneTransfer&) = delete;
+
+    ResolverStatus open(const string& host, uint16_t port);
+    void disconnect();
+
+    ResolverStatus run(const string& zone, RR_TYPE type, uint32_t serial, const RecordHandler& handle_record,
+                       int timeout_ms = MAX_RESPONSE_WAIT_SEC * 1000);
+
+    const TransferSummary& getSummary() const {
+        return summary;
+    }
+    // details of the last error (e.g. response code of refused transfer)
+    const string& getError() const {
+        return error;
+    }
+
+private:
+    ResolverStatus sendQuery(const string& zone, RR_TYPE type, uint32_t serial);
+    ResolverStatus handleMessage(const uint8_t* message, size_t length, const RecordHandler& handle_record, Arena& arena);
+
+    int socket_fd = -1;
+    string error;
+    TransferSummary summary;
+
+    uint16_t id = 0;
+    bool ixfr = false;
+    // serial of zone copy of client (IXFR)
+    uint32_t requested_serial = 0;
+    // SOA records with serial of the first SOA seen so far, transfer ends with the last one
+    int soa_count = 0;
+    // IXFR with incremental changes (second record is SOA), current SOA appears three times instead of two
+    bool incremental = false;
+    bool done = false;
+};
+
+#endif // TRANSFER_H
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+# @file transfer_server.py
+# @author Marek Gergel (xgerge01)
+# @brief scripted authoritative server of zone transfers (AXFR and IXFR over TCP) for test.sh
+# @version 0.1
+# @date 2026-10-18
+#
+# Serves zone transfer.test with current serial 5 on 127.0.0.1, listening port is printed on the first line.
+# AXFR: SOA, AXFR_RECORDS address records and SOA, split into messages of MESSAGE_RECORDS records.
+# IXFR with older serial: incremental changes (current SOA three times), sent in two messages.
+# IXFR with current or newer serial: current SOA only (zone is up to date).
+# Zone single.transfer.test is served the same way, but every record is sent in its own message.
+
+import socket
+import struct
+import sys
+
+ZONE = 'transfer.test'
+SERIAL = 5
+AXFR_RECORDS = 250
+MESSAGE_RECORDS = 100
+
+
+def zone_of(query):
+    labels = []
+    offset = 12
+    while query[offset] != 0:
+        labels.append(query[offset + 1:offset + 1 + query[offset]].decode().lower())
+        offset += 1 + query[offset]
+    return '.'.join(labels)
+
+
+def encode_name(name):
+    out = b''
+    for label in name.rstrip('.').split('.'):
+        out += bytes([len(label)]) + label.encode()
+    return out + b'\0'
+
+
+def skip_name(message, offset):
+    while True:
+        length = message[offset]
+        if length & 0xc0 == 0xc0:
+            return offset + 2
+        offset += 1 + length
+        if length == 0:
+            return offset
+
+
+def record(name, rtype, rdata):
+    return encode_name(name) + struct.pack('!HHIH', rtype, 1, 3600, len(rdata)) + rdata
+
+
+def soa(zone, serial):
+    return record(zone, 6, encode_name('ns.' + zone) + encode_name('admin.' + zone) +
+                  struct.pack('!IIIII', serial, 7200, 900, 86400, 300))
+
+
+def address(zone, index, last_octet):
+    return record('h%d.%s' % (index, zone), 1, bytes([10, 0, index & 0xff, last_octet]))
+
+
+def requested_serial(query, offset):
+    # SOA of client copy is the first authority record of IXFR query
+    offset = skip_name(query, offset)
+    rdata = offset + 10
+    rdata = skip_name(query, skip_name(query, rdata))
+    return struct.unpack('!I', query[rdata:rdata + 4])[0]
+
+
+def messages(query):
+    offset = skip_name(query, 12)
+    qtype = struct.unpack('!H', query[offset:offset + 2])[0]
+    question = query[12:offset + 4]
+    zone = zone_of(query)
+    per_message = 1 if zone == 'single.' + ZONE else MESSAGE_RECORDS
+    if zone not in (ZONE, 'single.' + ZONE):
+        return [], question
+    if qtype == 252:
+        records = [soa(zone, SERIAL)] + [address(zone, i, 1) for i in range(AXFR_RECORDS)] + [soa(zone, SERIAL)]
+    elif qtype == 251 and requested_serial(query, offset + 4) < SERIAL:
+        records = [soa(zone, SERIAL), soa(zone, SERIAL - 1), address(zone, 0, 1), soa(zone, SERIAL), address(zone, 0, 2),
+                   soa(zone, SERIAL)]
+        if per_message > 1:
+            return [records[:3], records[3:]], question
+    elif qtype == 251:
+        records = [soa(zone, SERIAL)]
+    else:
+        return [], question
+    return [records[i:i + per_message] for i in range(0, len(records), per_message)], question
+
+
+def serve(client):
+    length = client.recv(2)
+    if len(length) < 2:
+        return
+    size = struct.unpack('!H', length)[0]
+    query = b''
+    while len(query) < size:
+        chunk = client.recv(size - len(query))
+        if not chunk:
+            return
+        query += chunk
+    parts, question = messages(query)
+    for index, part in enumerate(parts):
+        # question is repeated only in the first message
+        message = query[:2] + struct.pack('!HHHHH', 0x8400, 1 if index == 0 else 0, len(part), 0, 0) + \
+            (question if index == 0 else b'') + b''.join(part)
+        client.sendall(struct.pack('!H', len(message)) + message)
+
+
+def main():
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(('127.0.0.1', int(sys.argv[1]) if len(sys.argv) > 1 else 0))
+    server.listen(4)
+    print(server.getsockname()[1], flush=True)
+    while True:
+        client, _ = server.accept()
+        with client:
+            serve(client)
+
+
+if __name__ == '__main__':
+    main()
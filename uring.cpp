@@ -0,0 +1,345 @@
+/**
+ * @file uring.cpp
+ * @author Marek Gergel (xgerge01)
+ * @brief definition of io_uring backend of resolver socket (raw system calls, no liburing), part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#include "uring.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include "dns.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define URING_SUPPORTED 1
+#endif
+
+using namespace std;
+
+static_assert((URING_BUFFERS & (URING_BUFFERS - 1)) == 0, "buffer ring size must be power of two");
+
+#ifdef URING_SUPPORTED
+
+// user data of completions
+static constexpr uint64_t SEND_TAG = 1;
+static constexpr uint64_t RECEIVE_TAG = 2;
+// group of provided buffers used by multishot receive
+static constexpr uint16_t BUFFER_GROUP = 0;
+
+/**
+ * @brief Memory shared with kernel: submission and completion rings, submission entries,
+ * provided buffer ring and receive buffers
+ */
+struct UringBackend::Rings {
+    void* ring = MAP_FAILED;
+    size_t ring_size = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqes_size = 0;
+    void* buffer_ring = MAP_FAILED;
+    size_t buffer_ring_size = 0;
+    uint8_t* buffers = static_cast<uint8_t*>(MAP_FAILED);
+    size_t buffers_size = 0;
+
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned sq_mask = 0;
+    unsigned sq_entries = 0;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned cq_mask = 0;
+    io_uring_cqe* cqes = nullptr;
+    // tail of provided buffer ring overlays reserved field of its first entry
+    io_uring_buf* bufs = nullptr;
+    uint16_t* buf_tail = nullptr;
+
+    ~Rings() {
+        if (ring != MAP_FAILED) {
+            munmap(ring, ring_size);
+        }
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqes_size);
+        }
+        if (buffer_ring != MAP_FAILED) {
+            munmap(buffer_ring, buffer_ring_size);
+        }
+        if (buffers != MAP_FAILED) {
+            munmap(buffers, buffers_size);
+        }
+    }
+
+    /**
+     * @brief Returns buffer to provided buffer ring, kernel sees it after tail is published
+     * @param buffer index of buffer
+     */
+    void addBuffer(const uint16_t buffer) {
+        io_uring_buf& entry = bufs[*buf_tail & (URING_BUFFERS - 1)];
+        entry.addr = reinterpret_cast<uint64_t>(buffers + static_cast<size_t>(buffer) * BUFFER_SIZE);
+        entry.len = BUFFER_SIZE;
+        entry.bid = buffer;
+        __atomic_store_n(buf_tail, static_cast<uint16_t>(*buf_tail + 1), __ATOMIC_RELEASE);
+    }
+};
+
+/**
+ * @brief Creates ring for connected socket, registers provided buffer ring and starts multishot receive
+ * @param socket_fd connected UDP socket
+ * @param error reason why io_uring cannot be used (old kernel, disabled by system)
+ * @return true when backend is ready, otherwise socket is used directly
+ */
+bool UringBackend::open(const int socket_fd, string& error) {
+    stop();
+
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = URING_COMPLETIONS;
+    const long fd = syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+    if (fd < 0) {
+        error = string("io_uring_setup failed (") + strerror(errno) + ")";
+        return false;
+    }
+    ring_fd = static_cast<int>(fd);
+    this->socket_fd = socket_fd;
+    rings = make_unique<Rings>();
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP)) {
+        error = "kernel io_uring is too old";
+        stop();
+        return false;
+    }
+
+    // Submission and completion rings share one mapping
+    rings->ring_size = max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                           params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    rings->ring = mmap(nullptr, rings->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    rings->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    rings->sqes = static_cast<io_uring_sqe*>(mmap(nullptr, rings->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                                  ring_fd, IORING_OFF_SQES));
+    rings->buffer_ring_size = URING_BUFFERS * sizeof(io_uring_buf);
+    rings->buffer_ring = mmap(nullptr, rings->buffer_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    rings->buffers_size = static_cast<size_t>(URING_BUFFERS) * BUFFER_SIZE;
+    rings->buffers = static_cast<uint8_t*>(mmap(nullptr, rings->buffers_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (rings->ring == MAP_FAILED || rings->sqes == MAP_FAILED || rings->buffer_ring == MAP_FAILED || rings->buffers == MAP_FAILED) {
+        error = string("io_uring memory cannot be mapped (") + strerror(errno) + ")";
+        stop();
+        return false;
+    }
+
+    auto* ring = static_cast<uint8_t*>(rings->ring);
+    rings->sq_head = reinterpret_cast<unsigned*>(ring + params.sq_off.head);
+    rings->sq_tail = reinterpret_cast<unsigned*>(ring + params.sq_off.tail);
+    rings->sq_mask = *reinterpret_cast<unsigned*>(ring + params.sq_off.ring_mask);
+    rings->sq_entries = params.sq_entries;
+    rings->sq_array = reinterpret_cast<unsigned*>(ring + params.sq_off.array);
+    rings->cq_head = reinterpret_cast<unsigned*>(ring + params.cq_off.head);
+    rings->cq_tail = reinterpret_cast<unsigned*>(ring + params.cq_off.tail);
+    rings->cq_mask = *reinterpret_cast<unsigned*>(ring + params.cq_off.ring_mask);
+    rings->cqes = reinterpret_cast<io_uring_cqe*>(ring + params.cq_off.cqes);
+
+    // Register provided buffer ring (Linux 5.19) and give all buffers to kernel
+    rings->bufs = static_cast<io_uring_buf*>(rings->buffer_ring);
+    rings->buf_tail = &rings->bufs[0].resv;
+    io_uring_buf_reg registration{};
+    registration.ring_addr = reinterpret_cast<uint64_t>(rings->buffer_ring);
+    registration.ring_entries = URING_BUFFERS;
+    registration.bgid = BUFFER_GROUP;
+    if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0) {
+        error = string("provided buffer ring cannot be registered (") + strerror(errno) + ")";
+        stop();
+        return false;
+    }
+    for (unsigned i = 0; i < URING_BUFFERS; i++) {
+        rings->addBuffer(static_cast<uint16_t>(i));
+    }
+
+    if (!armReceive()) {
+        error = string("multishot receive cannot be submitted (") + strerror(errno) + ")";
+        stop();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Destroys ring, pending receive is cancelled, socket stays open
+ */
+void UringBackend::stop() {
+    if (ring_fd != -1) {
+        ::close(ring_fd);
+        ring_fd = -1;
+    }
+    rings.reset();
+    queued = 0;
+    send_fails = 0;
+    receive_armed = false;
+}
+
+/**
+ * @brief Queues send of packet, it is submitted by flush (or earlier when submission queue is full)
+ * @param data packet, must stay valid until it is sent
+ * @param size size of packet
+ * @return false when queue cannot be submitted
+ */
+bool UringBackend::queueSend(const uint8_t* data, const size_t size) {
+    const unsigned tail = *rings->sq_tail;
+    if (tail - __atomic_load_n(rings->sq_head, __ATOMIC_ACQUIRE) >= rings->sq_entries && (!flush() || queued > 0)) {
+        return false;
+    }
+    const unsigned index = tail & rings->sq_mask;
+    io_uring_sqe& sqe = rings->sqes[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_SEND;
+    sqe.fd = socket_fd;
+    sqe.addr = reinterpret_cast<uint64_t>(data);
+    sqe.len = static_cast<uint32_t>(size);
+    sqe.user_data = SEND_TAG;
+    rings->sq_array[index] = index;
+    __atomic_store_n(rings->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    queued++;
+    return true;
+}
+
+/**
+ * @brief Submits all queued entries in one system call
+ * @return false when submission failed
+ */
+bool UringBackend::flush() {
+    while (queued > 0) {
+        const long submitted = syscall(__NR_io_uring_enter, ring_fd, queued, 0, 0, nullptr, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // completion queue is full, entries stay queued until completions are read
+            return errno == EAGAIN || errno == EBUSY;
+        }
+        queued -= static_cast<unsigned>(submitted);
+    }
+    return true;
+}
+
+/**
+ * @brief Submits multishot receive into buffers of provided buffer ring (Linux 6.0)
+ * @return false when submission failed
+ */
+bool UringBackend::armReceive() {
+    const unsigned tail = *rings->sq_tail;
+    if (tail - __atomic_load_n(rings->sq_head, __ATOMIC_ACQUIRE) >= rings->sq_entries && (!flush() || queued > 0)) {
+        return false;
+    }
+    const unsigned index = tail & rings->sq_mask;
+    io_uring_sqe& sqe = rings->sqes[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_RECV;
+    sqe.fd = socket_fd;
+    sqe.ioprio = IORING_RECV_MULTISHOT;
+    sqe.flags = IOSQE_BUFFER_SELECT;
+    sqe.buf_group = BUFFER_GROUP;
+    sqe.user_data = RECEIVE_TAG;
+    rings->sq_array[index] = index;
+    __atomic_store_n(rings->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    queued++;
+    receive_armed = true;
+    return flush();
+}
+
+/**
+ * @brief Reads completions until the next received packet, send completions are only counted.
+ * Receive that stopped (all buffers in use) is submitted again
+ * @param packet received packet, its buffer must be returned by recycle
+ * @return 1 for packet, 0 when there are no more completions, negative errno when receive failed
+ */
+int UringBackend::nextPacket(UringPacket& packet) {
+    while (true) {
+        const unsigned head = *rings->cq_head;
+        if (head == __atomic_load_n(rings->cq_tail, __ATOMIC_ACQUIRE)) {
+            return 0;
+        }
+        const io_uring_cqe cqe = rings->cqes[head & rings->cq_mask];
+        __atomic_store_n(rings->cq_head, head + 1, __ATOMIC_RELEASE);
+
+        if (cqe.user_data == SEND_TAG) {
+            send_fails += cqe.res < 0 ? 1 : 0;
+            continue;
+        }
+        if (!(cqe.flags & IORING_CQE_F_MORE)) {
+            receive_armed = false;
+        }
+        if (cqe.res < 0) {
+            // buffers were exhausted, they are free again when caller recycled processed packets
+            if (cqe.res == -ENOBUFS && !receive_armed && !armReceive()) {
+                return -errno;
+            }
+            if (cqe.res == -ENOBUFS) {
+                continue;
+            }
+            if (!receive_armed && cqe.res != -EINVAL && cqe.res != -EOPNOTSUPP) {
+                armReceive();
+            }
+            return cqe.res;
+        }
+        if (!(cqe.flags & IORING_CQE_F_BUFFER)) {
+            continue;
+        }
+        packet.buffer = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        packet.data = rings->buffers + static_cast<size_t>(packet.buffer) * BUFFER_SIZE;
+        packet.length = static_cast<size_t>(cqe.res);
+        if (!receive_armed && !armReceive()) {
+            return -errno;
+        }
+        return 1;
+    }
+}
+
+/**
+ * @brief Returns buffer of processed packet to kernel
+ * @param buffer buffer of packet
+ */
+void UringBackend::recycle(const uint16_t buffer) {
+    rings->addBuffer(buffer);
+}
+
+#else // portable build, backend is never available
+
+struct UringBackend::Rings {};
+
+bool UringBackend::open(const int, string& error) {
+    error = "io_uring is supported only on Linux";
+    return false;
+}
+
+void UringBackend::stop() {
+    ring_fd = -1;
+}
+
+bool UringBackend::queueSend(const uint8_t*, const size_t) {
+    return false;
+}
+
+bool UringBackend::flush() {
+    return false;
+}
+
+int UringBackend::nextPacket(UringPacket&) {
+    return 0;
+}
+
+void UringBackend::recycle(const uint16_t) {}
+
+bool UringBackend::armReceive() {
+    return false;
+}
+
+#endif // URING_SUPPORTED
+
+// defined where Rings is complete
+UringBackend::UringBackend() = default;
+
+UringBackend::~UringBackend() {
+    stop();
+}
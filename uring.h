@@ -0,0 +1,82 @@
+/**
+ * @file uring.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of io_uring backend of resolver socket (raw system calls, no liburing), part of libdns library
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef URING_H
+#define URING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// submission queue entries, sends beyond this are submitted in more system calls
+constexpr unsigned URING_ENTRIES = 256;
+// completion queue holds completions of a full window of sends and all receive buffers
+constexpr unsigned URING_COMPLETIONS = 8192;
+// receive buffers of provided buffer ring, each BUFFER_SIZE bytes (power of two)
+constexpr unsigned URING_BUFFERS = 256;
+
+/**
+ * @brief Received packet in buffer of provided buffer ring, buffer is returned to ring by recycle
+ */
+struct UringPacket {
+    const uint8_t* data = nullptr;
+    size_t length = 0;
+    uint16_t buffer = 0;
+};
+
+/**
+ * @brief io_uring instance serving one connected UDP socket. Sends are queued into submission queue
+ * and submitted together by flush (one system call for a batch of queries), responses are received
+ * by one multishot receive into buffers picked by kernel from provided buffer ring, so receiving
+ * needs no system call while completions are ready. Ring descriptor is readable when completions are ready,
+ * so it is polled instead of the socket
+ */
+class UringBackend {
+public:
+    UringBackend();
+    ~UringBackend();
+    UringBackend(const UringBackend&) = delete;
+    UringBackend& operator=(const UringBackend&) = delete;
+
+    bool open(int socket_fd, std::string& error);
+    void stop();
+
+    bool queueSend(const uint8_t* data, size_t size);
+    bool flush();
+    int nextPacket(UringPacket& packet);
+    void recycle(uint16_t buffer);
+
+    bool isOpen() const {
+        return ring_fd != -1;
+    }
+    // descriptor to poll for completions
+    int getFd() const {
+        return ring_fd;
+    }
+    // sends completed with error since the last call
+    unsigned takeSendFails() {
+        const unsigned fails = send_fails;
+        send_fails = 0;
+        return fails;
+    }
+
+private:
+    struct Rings;
+
+    bool armReceive();
+
+    int ring_fd = -1;
+    int socket_fd = -1;
+    std::unique_ptr<Rings> rings;
+    unsigned queued = 0;
+    unsigned send_fails = 0;
+    bool receive_armed = false;
+};
+
+#endif // URING_H
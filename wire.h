@@ -0,0 +1,279 @@
+/**
+ * @file wire.h
+ * @author Marek Gergel (xgerge01)
+ * @brief declaration of typed view of dns wire format (big endian fields, header overlay, bounds checked cursors)
+ * @version 0.1
+ * @date 2026-10-18
+ */
+
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+/**
+ * @brief Reverses order of bytes, written as shifts so compiler emits single bswap (rol for 16 bits)
+ * @param value value to swap
+ * @return value with reversed bytes
+ */
+template <class T>
+constexpr T byte_swap(const T value) {
+    static_assert(std::is_unsigned_v<T>, "only unsigned integers can be swapped");
+    if constexpr (sizeof(T) == 1) {
+        return value;
+    } else if constexpr (sizeof(T) == 2) {
+        return static_cast<T>(value << 8 | value >> 8);
+    } else if constexpr (sizeof(T) == 4) {
+        return (value << 24) | ((value << 8) & 0x00ff0000u) | ((value >> 8) & 0x0000ff00u) | (value >> 24);
+    } else {
+        static_assert(sizeof(T) == 8, "unsupported integer size");
+        return (static_cast<T>(byte_swap(static_cast<uint32_t>(value))) << 32) | byte_swap(static_cast<uint32_t>(value >> 32));
+    }
+}
+
+/**
+ * @brief Converts between host and network byte order, byte order of host is known at compile time
+ * @param value value in host (or network) byte order
+ * @return value in network (or host) byte order
+ */
+template <class T>
+constexpr T network_order(const T value) {
+    if constexpr (std::endian::native == std::endian::big) {
+        return value;
+    } else {
+        return byte_swap(value);
+    }
+}
+
+/**
+ * @brief Unsigned field stored in network byte order, it has no alignment requirement,
+ * so it can overlay any position of packet and it is read and written without unaligned access
+ */
+template <class T>
+class BigEndian {
+    static_assert(std::is_unsigned_v<T>, "field must be unsigned integer");
+
+public:
+    BigEndian() = default;
+    BigEndian(const T value) {
+        *this = value;
+    }
+
+    BigEndian& operator=(const T value) {
+        const T wire = network_order(value);
+        memcpy(bytes, &wire, sizeof(T));
+        return *this;
+    }
+
+    operator T() const {
+        T wire;
+        memcpy(&wire, bytes, sizeof(T));
+        return network_order(wire);
+    }
+
+private:
+    uint8_t bytes[sizeof(T)] = {};
+};
+
+/**
+ * @brief Header of message in wire format (RFC 1035 section 4.1.1)
+ */
+struct WireHeader {
+    BigEndian<uint16_t> id;
+    BigEndian<uint16_t> flags;
+    BigEndian<uint16_t> qdcount;
+    BigEndian<uint16_t> ancount;
+    BigEndian<uint16_t> nscount;
+    BigEndian<uint16_t> arcount;
+};
+
+/**
+ * @brief Fields of question following its name
+ */
+struct WireQuestion {
+    BigEndian<uint16_t> type;
+    BigEndian<uint16_t> class_;
+};
+
+/**
+ * @brief Fields of resource record following its name
+ */
+struct WireRecord {
+    BigEndian<uint16_t> type;
+    BigEndian<uint16_t> class_;
+    BigEndian<uint32_t> ttl;
+    BigEndian<uint16_t> rdlength;
+};
+
+/**
+ * @brief Fields of SOA record data following its two names
+ */
+struct WireSoa {
+    BigEndian<uint32_t> serial;
+    BigEndian<uint32_t> refresh;
+    BigEndian<uint32_t> retry;
+    BigEndian<uint32_t> expire;
+    BigEndian<uint32_t> minimum;
+};
+
+static_assert(sizeof(BigEndian<uint32_t>) == 4 && alignof(BigEndian<uint32_t>) == 1, "field must not be padded");
+static_assert(sizeof(WireHeader) == 12 && alignof(WireHeader) == 1, "header overlay must match wire format");
+static_assert(sizeof(WireQuestion) == 4 && sizeof(WireRecord) == 10 && sizeof(WireSoa) == 20, "overlay must match wire format");
+
+/**
+ * @brief Bounds checked cursor reading packet, read past end of packet returns nullptr (or zero) and invalidates cursor,
+ * so parser checks validity once after sequence of reads
+ */
+class WireReader {
+public:
+    WireReader(const uint8_t* data, const size_t length, const size_t offset = 0)
+        : data(data), length(length), offset(offset), valid(offset <= length) {}
+
+    /**
+     * @brief Overlays structure of fields at cursor and moves cursor after it
+     * @return view of fields, nullptr when they do not fit into packet
+     */
+    template <class T>
+    const T* view() {
+        static_assert(alignof(T) == 1, "overlay must not require alignment");
+        if (!skip(sizeof(T))) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(data + offset - sizeof(T));
+    }
+
+    /**
+     * @brief Reads unsigned number in network byte order
+     * @return number, zero when it does not fit into packet
+     */
+    template <class T>
+    T read() {
+        const BigEndian<T>* field = view<BigEndian<T>>();
+        return field != nullptr ? static_cast<T>(*field) : T{0};
+    }
+
+    bool skip(const size_t bytes) {
+        if (!valid || length - offset < bytes) {
+            valid = false;
+            return false;
+        }
+        offset += bytes;
+        return true;
+    }
+
+    /**
+     * @brief Skips name at cursor, compression pointer ends the name and is not followed
+     * @return false when name does not fit into packet
+     */
+    bool skipName() {
+        while (valid && offset < length) {
+            const uint8_t label = data[offset];
+            if (label == 0) {
+                return skip(1);
+            }
+            if ((label & 0xc0) == 0xc0) {
+                return skip(2);
+            }
+            skip(label + 1u);
+        }
+        valid = false;
+        return false;
+    }
+
+    // marks data at cursor as malformed
+    void fail() {
+        valid = false;
+    }
+
+    const uint8_t* getData() const {
+        return data;
+    }
+
+    const uint8_t* getEnd() const {
+        return data + length;
+    }
+
+    const uint8_t* getPosition() const {
+        return data + offset;
+    }
+
+    size_t getOffset() const {
+        return offset;
+    }
+
+    size_t getRemaining() const {
+        return length - offset;
+    }
+
+    bool isValid() const {
+        return valid;
+    }
+
+private:
+    const uint8_t* data;
+    size_t length;
+    size_t offset;
+    bool valid;
+};
+
+/**
+ * @brief Bounds checked cursor writing packet, write past end of buffer is dropped and invalidates cursor
+ */
+class WireWriter {
+public:
+    WireWriter(uint8_t* data, const size_t capacity) : data(data), capacity(capacity) {}
+
+    /**
+     * @brief Overlays structure of fields at cursor and moves cursor after it, fields are zeroed
+     * @return view of fields, nullptr when they do not fit into buffer
+     */
+    template <class T>
+    T* view() {
+        static_assert(alignof(T) == 1, "overlay must not require alignment");
+        if (!valid || capacity - offset < sizeof(T)) {
+            valid = false;
+            return nullptr;
+        }
+        T* fields = new (data + offset) T();
+        offset += sizeof(T);
+        return fields;
+    }
+
+    template <class T>
+    void write(const T value) {
+        BigEndian<T>* field = view<BigEndian<T>>();
+        if (field != nullptr) {
+            *field = value;
+        }
+    }
+
+    void writeBytes(const void* bytes, const size_t size) {
+        if (!valid || capacity - offset < size) {
+            valid = false;
+            return;
+        }
+        memcpy(data + offset, bytes, size);
+        offset += size;
+    }
+
+    size_t getOffset() const {
+        return offset;
+    }
+
+    bool isValid() const {
+        return valid;
+    }
+
+private:
+    uint8_t* data;
+    size_t capacity;
+    size_t offset = 0;
+    bool valid = true;
+};
+
+#endif // WIRE_H